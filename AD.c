@@ -13,6 +13,7 @@
 
 
 #include <serial.h>
+#include "ADWindow.h"
 
 #include <stdio.h>
 
@@ -33,8 +34,9 @@
 #define BAT_VOLTAGE_MONITOR BAT_VOLTAGE
 #endif
 
-#define BAT_VOLTAGE_LOCKOUT 263
-#define BAT_VOLTAGE_NO_BAT 169
+// battery mV at a full-scale reading: 3.3 V reference through the 10:1 divider
+#define BAT_MV_FULL_SCALE 33000u
+#define AD_FULL_SCALE 1023u
 
 //#define AD_DEBUG_VERBOSE
 #ifdef AD_DEBUG_VERBOSE
@@ -56,7 +58,13 @@
 #define ALLADPINS (AD_PORTV3|AD_PORTV4|AD_PORTV5|AD_PORTV6|AD_PORTV7|AD_PORTV8|AD_PORTW3|AD_PORTW4|AD_PORTW5|AD_PORTW6|AD_PORTW7|AD_PORTW8|BAT_VOLTAGE|ROACH_LIGHT_SENSOR)
 #define BATFILT_HISTORY_LENGTH 2
 #define POINTS_PER_SECOND_PER_PIN 9345
-#define FREQUENCY_TO_SAMPLE 1
+
+//oversampling: each published value is the mean of AD_OVERSAMPLE scans (power of 2)
+#define AD_OVERSAMPLE_SHIFT 2
+#define AD_OVERSAMPLE (1 << AD_OVERSAMPLE_SHIFT)
+//double buffering: the A/D fills one half of ADC1BUF while the interrupt reads the other
+#define AD_HALF_BUFFER 8
+#define AD_MAX_SCANS_PER_INT 2
 
 
 
@@ -86,25 +94,37 @@ static unsigned int ActivePins;
 static unsigned int PinsToAdd;
 static unsigned int PinsToRemove;
 static unsigned int PinCount;
-static unsigned int ADValues[NUM_AD_PINS];
 static int PortMapping[NUM_AD_PINS];
 
+//published results by pin, two copies: ReadyBuf is the last one completed, the
+//interrupt only ever writes the other
+static volatile unsigned int Results[2][NUM_AD_PINS];
+static volatile unsigned char ReadyBuf = 0;
+//oversampling sums by scan position, the pin at each position, and scans summed
+static unsigned int Accum[NUM_AD_PINS];
+static unsigned char ScanPin[NUM_AD_PINS];
+static unsigned int AccumScans = 0;
+static unsigned int ScansPerInt = 1;
+
 static char ADActive;
-static char ADNewData = FALSE;
+static volatile char ADNewData = FALSE;
+static AD_Stats_t Stats;
 
 
 static int Filt_BatVoltage = 1023;
-static int CurFilt_BatVoltage = 0;
-static int PrevFilt_BatVoltage = 0;
 //static uint16_t BatFiltHistory[BATFILT_HISTORY_LENGTH] = {0};
 //static uint8_t BatFiltHistoryCurPoint = -1;
-static uint32_t PointsPerBatSamples = 0;
-static uint32_t SampleCount = 0;
+
+static unsigned int SampleHookPin = 0;
+static int SampleHookPos = -1;
+static void (* volatile SampleHook)(unsigned int Value) = NULL;
 
 /*******************************************************************************
  * PRIVATE FUNCTION PROTOTYPES                                                            *
  ******************************************************************************/
 char AD_SetPins(void);
+static int AD_ScanPosition(unsigned int Pin);
+static void AD_Publish(void);
 
 /*******************************************************************************
  * PUBLIC FUNCTIONS                                                           *
@@ -128,8 +148,9 @@ char AD_Init(void)
     ADActive = TRUE;
     AD_SetPins();
     for (pin = 0; pin < NUM_AD_PINS; pin++) {
-        ADValues[pin] = -1;
+        Results[0][pin] = Results[1][pin] = -1;
     }
+    AD_ClearStats();
     IEC1bits.AD1IE = 0;
     IFS1bits.AD1IF = 0;
     IPC6bits.AD1IP = 1;
@@ -145,8 +166,6 @@ char AD_Init(void)
     }
     //set the first values for the battery monitor filter
     Filt_BatVoltage = AD_ReadADPin(BAT_VOLTAGE_MONITOR);
-    CurFilt_BatVoltage = Filt_BatVoltage;
-    PrevFilt_BatVoltage = Filt_BatVoltage;
 
     return SUCCESS;
 }
@@ -258,7 +277,139 @@ unsigned int AD_ReadADPin(unsigned int Pin)
         Pin >>= 1;
         TranslatedPin++;
     }
-    return ADValues[PortMapping[TranslatedPin]];
+    return Results[ReadyBuf][TranslatedPin];
+}
+
+/**
+ * @function AD_ReadBatteryFiltered(void)
+ * @param None
+ * @return Filtered battery reading in A/D counts, or ERROR before AD_Init
+ * @brief Returns the low-pass filtered battery reading kept by the A/D interrupt,
+ *        the value BatteryService grades. */
+unsigned int AD_ReadBatteryFiltered(void)
+{
+    if (!ADActive) {
+        dbprintf("%s returning ERROR before enable\r\n", __FUNCTION__);
+        return ERROR;
+    }
+    return Filt_BatVoltage;
+}
+
+/**
+ * @function AD_ReadBatteryMillivolts(void)
+ * @param None
+ * @return Filtered battery voltage in millivolts, or 0 before AD_Init
+ * @brief AD_ReadBatteryFiltered() scaled through the 10:1 divider and 3.3 V reference. */
+unsigned int AD_ReadBatteryMillivolts(void)
+{
+    if (!ADActive) {
+        return 0;
+    }
+    return ((unsigned int) Filt_BatVoltage * BAT_MV_FULL_SCALE) / AD_FULL_SCALE;
+}
+
+/**
+ * @function AD_SetSampleHook(unsigned int Pin, void (*Hook)(unsigned int Value))
+ * @param Pin - one #defined AD_PORTxxx, Hook - called with each new reading of it, or NULL
+ * @return SUCCESS or ERROR
+ * @brief Hands every new reading of Pin to Hook from the A/D interrupt, as soon as the
+ *        scan is read. Only one pin can be hooked; a NULL Hook removes it. */
+char AD_SetSampleHook(unsigned int Pin, void (*Hook)(unsigned int Value))
+{
+    if (!ADActive) {
+        dbprintf("%s called before enable\r\n", __FUNCTION__);
+        return ERROR;
+    }
+    if (Hook == NULL) {
+        SampleHook = NULL;
+        SampleHookPin = 0;
+        return SUCCESS;
+    }
+    if ((Pin == 0) || (Pin & (Pin - 1)) || (Pin > ALLADPINS)) {
+        dbprintf("%s returning ERROR with pin not a single A/D pin: %X\r\n", __FUNCTION__, Pin);
+        return ERROR;
+    }
+    SampleHook = NULL;
+    SampleHookPin = Pin;
+    SampleHookPos = AD_ScanPosition(Pin);
+    SampleHook = Hook;
+    return SUCCESS;
+}
+
+/**
+ * @function AD_SetWindow(unsigned int Pin, unsigned int Low, unsigned int High, unsigned int Hysteresis)
+ * @param Pin - one #defined AD_PORTxxx, Low/High - window edges in counts,
+ *        Hysteresis - counts back past an edge needed to leave its zone
+ * @return SUCCESS or ERROR
+ * @brief Watches Pin's published readings against the window: CheckADWindow posts
+ *        AD_WINDOW (param from ADWIN_PARAM) when a reading goes below Low, above High
+ *        or back inside. The pin need not be active yet. */
+char AD_SetWindow(unsigned int Pin, unsigned int Low, unsigned int High, unsigned int Hysteresis)
+{
+    unsigned char TranslatedPin = 0;
+    if ((Pin == 0) || (Pin & (Pin - 1)) || (Pin > ALLADPINS)) {
+        dbprintf("%s returning ERROR with pin not a single A/D pin: %X\r\n", __FUNCTION__, Pin);
+        return ERROR;
+    }
+    if ((Low > High) || (High > AD_FULL_SCALE)) {
+        dbprintf("%s returning ERROR with window %u..%u\r\n", __FUNCTION__, Low, High);
+        return ERROR;
+    }
+    while (Pin > 1) {
+        Pin >>= 1;
+        TranslatedPin++;
+    }
+    ADWindow_Set(TranslatedPin, Low, High, Hysteresis);
+    return SUCCESS;
+}
+
+/**
+ * @function AD_ClearWindow(unsigned int Pin)
+ * @param Pin - one #defined AD_PORTxxx
+ * @return SUCCESS or ERROR
+ * @brief Stops watching Pin and drops a crossing not yet posted. */
+char AD_ClearWindow(unsigned int Pin)
+{
+    unsigned char TranslatedPin = 0;
+    if ((Pin == 0) || (Pin & (Pin - 1)) || (Pin > ALLADPINS)) {
+        dbprintf("%s returning ERROR with pin not a single A/D pin: %X\r\n", __FUNCTION__, Pin);
+        return ERROR;
+    }
+    while (Pin > 1) {
+        Pin >>= 1;
+        TranslatedPin++;
+    }
+    ADWindow_Clear(TranslatedPin);
+    return SUCCESS;
+}
+
+/**
+ * @function AD_GetStats(AD_Stats_t *Out)
+ * @param Out - filled in with the counts since AD_ClearStats
+ * @return None
+ * @brief Interrupt count, results published and time spent in the A/D interrupt. */
+void AD_GetStats(AD_Stats_t *Out)
+{
+    char WasOn = IEC1bits.AD1IE;
+    IEC1bits.AD1IE = 0;
+    *Out = Stats;
+    IEC1bits.AD1IE = WasOn;
+}
+
+/**
+ * @function AD_ClearStats(void)
+ * @param None
+ * @return None
+ * @brief Zeroes the A/D interrupt statistics. */
+void AD_ClearStats(void)
+{
+    char WasOn = IEC1bits.AD1IE;
+    IEC1bits.AD1IE = 0;
+    Stats.Interrupts = 0;
+    Stats.Frames = 0;
+    Stats.BusyTicks = 0;
+    Stats.MaxTicks = 0;
+    IEC1bits.AD1IE = WasOn;
 }
 
 /**
@@ -278,7 +429,7 @@ void AD_End(void)
     PinsToRemove = ALLADPINS;
     AD_SetPins();
     for (pin = 0; pin < NUM_AD_PINS; pin++) {
-        ADValues[pin] = -1;
+        Results[0][pin] = Results[1][pin] = -1;
     }
     ActivePins = 0;
     PinCount = 0;
@@ -336,9 +487,23 @@ char AD_SetPins(void)
     for (CurPin = 0; CurPin < NUM_AD_PINS_UNO; CurPin++) {//translate AD Mapping to Port Mapping
         if (ADMapping[CurPin] != -1) {
             PortMapping[ADMapping[CurPin]] = CurPinOrder;
+            ScanPin[CurPinOrder] = ADMapping[CurPin];
+            Accum[CurPinOrder] = 0;
             CurPinOrder++;
         }
     }
+    AccumScans = 0;
+    SampleHookPos = SampleHookPin ? AD_ScanPosition(SampleHookPin) : -1;
+    //as many scans per interrupt as fit in half the buffer, so the A/D fills one half
+    //while the interrupt reads the other; more pins than that use the whole buffer
+    if (PinCount && PinCount <= AD_HALF_BUFFER) {
+        ScansPerInt = AD_HALF_BUFFER / PinCount;
+        if (ScansPerInt > AD_MAX_SCANS_PER_INT) {
+            ScansPerInt = AD_MAX_SCANS_PER_INT;
+        }
+    } else {
+        ScansPerInt = 1;
+    }
 
     AD1CON1bits.FORM = 0; // output is unsigned integer
     AD1CON1bits.SSRC = 0b111; // internal counter handles timing of sampling an conversion
@@ -346,8 +511,8 @@ char AD_SetPins(void)
 
     AD1CON2bits.VCFG = 0; // use AVdd and AVss for + and -
     AD1CON2bits.CSCNA = 1; // mux inputs together
-    AD1CON2bits.SMPI = PinCount - 1; // set the number to scan for 1 less than wanted as zero is 1 to scan
-    AD1CON2bits.BUFM = 0; // configure bugger as one large buffer
+    AD1CON2bits.SMPI = PinCount * ScansPerInt - 1; // conversions per interrupt, less one
+    AD1CON2bits.BUFM = (PinCount <= AD_HALF_BUFFER); // two 8-word halves, else one large buffer
 
     AD1CON3bits.ADRC = 0; // use Peripheral clock for timing
     AD1CON3bits.SAMC = 29; // set the sample time, completely arbitrary, nearly the slowest possible
@@ -361,50 +526,98 @@ char AD_SetPins(void)
     //            ADC_SAMPLE_TIME_29 | ADC_CONV_CLK_51Tcy2 | ADC_CONV_CLK_PB, pcfg, cssl);
     AD1PCFGSET = rempcfg;
     AD1CON1SET = _AD1CON1_ON_MASK;
-    //recalculate interval between battery samples
-    PointsPerBatSamples = (POINTS_PER_SECOND_PER_PIN / PinCount) / (float) FREQUENCY_TO_SAMPLE;
     PinsToAdd = 0;
     PinsToRemove = 0;
     IEC1bits.AD1IE = 1;
     return SUCCESS;
 }
 
+/**
+ * @function AD_ScanPosition(unsigned int Pin)
+ * @param Pin - one #defined AD_PORTxxx
+ * @return Position of Pin in each scan, or -1 if it is not active
+ * @note Private Function. */
+static int AD_ScanPosition(unsigned int Pin)
+{
+    unsigned char TranslatedPin = 0;
+    if (!(ActivePins & Pin)) {
+        return -1;
+    }
+    while (Pin > 1) {
+        Pin >>= 1;
+        TranslatedPin++;
+    }
+    return PortMapping[TranslatedPin];
+}
+
+/**
+ * @function AD_Publish(void)
+ * @param None
+ * @return None
+ * @brief Decimates the oversampling sums into the results copy not being read, makes
+ *        it the current one, checks each value against its window (AD_SetWindow) and
+ *        updates the battery filter from it.
+ * @note Private Function, called from the interrupt. */
+static void AD_Publish(void)
+{
+    unsigned char Next = ReadyBuf ^ 1;
+    unsigned int Pos, Value;
+    for (Pos = 0; Pos < PinCount; Pos++) {
+        Value = (Accum[Pos] + AD_OVERSAMPLE / 2) >> AD_OVERSAMPLE_SHIFT;
+        Results[Next][ScanPin[Pos]] = Value;
+        ADWindow_Sample(ScanPin[Pos], Value);
+        Accum[Pos] = 0;
+    }
+    AccumScans = 0;
+    ReadyBuf = Next;
+    //calculate new filtered battery voltage
+    Filt_BatVoltage = (Filt_BatVoltage * KEEP_FILT + AD_ReadADPin(BAT_VOLTAGE_MONITOR) * ADD_FILT) >> SHIFT_FILT;
+    //undervoltage is graded and acted on by BatteryService, not in here
+    Stats.Frames++;
+    ADNewData = TRUE;
+}
+
 /**
  * @function ADCIntHandler
  * @param None
  * @return None
- * @brief Interrupt Handler for A/D. Reads all used pins into buffer.
+ * @brief Interrupt Handler for A/D. Adds each scan in the buffer half just filled to
+ *        the oversampling sums and publishes every AD_OVERSAMPLE scans.
  * @note This function is not to be called by the user
  * @author Max Dunne, 2013.08.25 */
 void __ISR(_ADC_VECTOR) ADCIntHandler(void)
 {
-    unsigned char CurPin = 0;
+    unsigned int Start = _CP0_GET_COUNT();
+    volatile unsigned int *Buf = &ADC1BUF0;
+    unsigned int Scan, Pos, Ticks;
     IFS1bits.AD1IF = 0;
-    for (CurPin = 0; CurPin <= PinCount; CurPin++) {
-        ADValues[CurPin] = (*(&ADC1BUF0+((CurPin) * 4))); //read in new set of values, pointer math from microchip
+    //split buffer: BUFS = 0 means the A/D is filling the lower half, so read the upper
+    if (AD1CON2bits.BUFM && !AD1CON2bits.BUFS) {
+        Buf += AD_HALF_BUFFER * 4;
     }
-    //calculate new filtered battery voltage
-    Filt_BatVoltage = (Filt_BatVoltage * KEEP_FILT + AD_ReadADPin(BAT_VOLTAGE_MONITOR) * ADD_FILT) >> SHIFT_FILT;
-
-    SampleCount++;
-    if (SampleCount > PointsPerBatSamples) {//if sample time has passed
-        PrevFilt_BatVoltage = CurFilt_BatVoltage;
-        CurFilt_BatVoltage = Filt_BatVoltage;
-        SampleCount = 0;
-        //check for battery undervoltage check
-        if ((CurFilt_BatVoltage <= BAT_VOLTAGE_LOCKOUT) && (PrevFilt_BatVoltage <= BAT_VOLTAGE_LOCKOUT) && (AD_ReadADPin(BAT_VOLTAGE_MONITOR) > BAT_VOLTAGE_NO_BAT)) {
-            BOARD_End();
-            while (1) {
-                printf("Battery is undervoltage with reading %d, Going to sleep\r\n", AD_ReadADPin(BAT_VOLTAGE_MONITOR));
-                while (!IsTransmitEmpty());
-            }
+    for (Scan = 0; Scan < ScansPerInt; Scan++) {
+        for (Pos = 0; Pos < PinCount; Pos++) {
+            Accum[Pos] += Buf[(Scan * PinCount + Pos) * 4]; //buffer registers are 16 bytes apart
+        }
+        //hand each raw reading of the hooked pin over as it comes
+        if (SampleHook && SampleHookPos >= 0) {
+            SampleHook(Buf[(Scan * PinCount + SampleHookPos) * 4]);
+        }
+        if (++AccumScans >= AD_OVERSAMPLE) {
+            AD_Publish();
         }
     }
+
     //if pins are changed add pins
     if (PinsToAdd | PinsToRemove) {
         AD_SetPins();
     }
-    ADNewData = TRUE;
+    Ticks = _CP0_GET_COUNT() - Start;
+    Stats.Interrupts++;
+    Stats.BusyTicks += Ticks;
+    if (Ticks > Stats.MaxTicks) {
+        Stats.MaxTicks = Ticks;
+    }
 }
 
 
@@ -39,6 +39,14 @@
 #define BAT_VOLTAGE (1<<12)
 #define ROACH_LIGHT_SENSOR (1<<13)
 
+/* A/D interrupt statistics, see AD_GetStats. Ticks are core timer ticks (SYSCLK/2). */
+typedef struct {
+    unsigned int Interrupts;    // A/D interrupts taken
+    unsigned int Frames;        // oversampled result sets published
+    unsigned int BusyTicks;     // time spent in the interrupt
+    unsigned int MaxTicks;      // longest single interrupt
+} AD_Stats_t;
+
 
 /*******************************************************************************
  * PUBLIC FUNCTION PROTOTYPES                                                  *
@@ -92,10 +100,76 @@ char AD_IsNewDataReady(void);
  * @function AD_ReadADPin(unsigned int Pin)
  * @param Pin - Used #defined AD_PORTxxx to select pin
  * @return 10-bit AD Value or ERROR
- * @brief Reads current value from buffer for given pin
+ * @brief Reads the latest value for given pin: the mean of the last AD_OVERSAMPLE (4) scans,
+ *        from the result set the interrupt last completed. The interrupt only writes
+ *        the other set, so this never blocks it and never sees a half-written value.
  * @author Max Dunne, 2011.12.10 */
 unsigned int AD_ReadADPin(unsigned int Pin);
 
+/**
+ * @function AD_ReadBatteryFiltered(void)
+ * @param None
+ * @return Filtered battery reading in A/D counts, or ERROR before AD_Init
+ * @brief Returns the low-pass filtered battery reading kept by the A/D interrupt,
+ *        the value BatteryService grades. */
+unsigned int AD_ReadBatteryFiltered(void);
+
+/**
+ * @function AD_ReadBatteryMillivolts(void)
+ * @param None
+ * @return Filtered battery voltage in millivolts, or 0 before AD_Init
+ * @brief AD_ReadBatteryFiltered() scaled through the 10:1 divider and 3.3 V reference. */
+unsigned int AD_ReadBatteryMillivolts(void);
+
+/**
+ * @function AD_SetSampleHook(unsigned int Pin, void (*Hook)(unsigned int Value))
+ * @param Pin - one #defined AD_PORTxxx, Hook - called with each new reading of it, or NULL
+ * @return SUCCESS or ERROR
+ * @brief Hands every new reading of Pin to Hook from the A/D interrupt (IPL1), for
+ *        signals that need acting on faster than the main loop polls. Readings are raw
+ *        (not oversampled), one per scan; with few pins an interrupt carries two scans
+ *        and the hook is called twice in a row. Only one pin can be hooked; a NULL Hook
+ *        removes it. Keep the hook short.
+ * @note The pin must also be added with AD_AddPins; the hook is not called until it is
+ *       active. */
+char AD_SetSampleHook(unsigned int Pin, void (*Hook)(unsigned int Value));
+
+/**
+ * @function AD_SetWindow(unsigned int Pin, unsigned int Low, unsigned int High, unsigned int Hysteresis)
+ * @param Pin - one #defined AD_PORTxxx, Low/High - window edges in counts,
+ *        Hysteresis - counts back past an edge needed to leave its zone
+ * @return SUCCESS or ERROR
+ * @brief Window comparator on Pin: each published (oversampled) reading is checked from
+ *        the A/D interrupt, and CheckADWindow posts AD_WINDOW when the reading goes below
+ *        Low, above High or back inside. The param packs the channel, zone and reading
+ *        (ADWIN_PARAM_PIN/_ZONE/_VALUE in ADWindow.h). Each pin posts at most once per
+ *        ADWIN_MIN_INTERVAL_MS; crossings in between fold into the latest one. Setting a
+ *        window again restarts it inside.
+ * @note The pin must also be added with AD_AddPins; until it is active nothing is posted. */
+char AD_SetWindow(unsigned int Pin, unsigned int Low, unsigned int High, unsigned int Hysteresis);
+
+/**
+ * @function AD_ClearWindow(unsigned int Pin)
+ * @param Pin - one #defined AD_PORTxxx
+ * @return SUCCESS or ERROR
+ * @brief Stops the window comparator on Pin; a crossing not yet posted is dropped. */
+char AD_ClearWindow(unsigned int Pin);
+
+/**
+ * @function AD_GetStats(AD_Stats_t *Out)
+ * @param Out - filled in with the counts since AD_ClearStats (or AD_Init)
+ * @return None
+ * @brief Interrupt count, result sets published and time spent in the A/D interrupt,
+ *        for its rate and CPU load. BusyTicks wraps after about 107 s of interrupt time. */
+void AD_GetStats(AD_Stats_t *Out);
+
+/**
+ * @function AD_ClearStats(void)
+ * @param None
+ * @return None
+ * @brief Zeroes the A/D interrupt statistics. */
+void AD_ClearStats(void);
+
 /**
  * @function AD_End(void)
  * @param None
@@ -0,0 +1,300 @@
+/* =============================================================================
+ * File:    ADWindow.c
+ * Purpose: Window comparator on the A/D readings: flags a channel when its
+ *          reading drops below, rises above or comes back inside a window,
+ *          so nothing has to poll AD_ReadADPin() to catch a threshold.
+ *
+ * Dependencies:
+ *   - none; AD.c feeds it from the A/D interrupt
+ *
+ * Behavior:
+ *   - AD.c hands every published (oversampled) reading of each active pin
+ *     to ADWindow_Sample() from the A/D interrupt. Watched channels keep a
+ *     zone; a change of zone latches the zone and reading in one 16-bit
+ *     word and marks the channel pending. Nothing else runs in interrupt.
+ *   - Leaving a zone takes 'hyst' counts back past its edge, so a reading
+ *     sitting on a threshold does not chatter.
+ *   - CheckADWindow() (SensorMotorEventChecker.c) calls ADWindow_Next() each
+ *     pass and posts AD_WINDOW with what it returns. One slot per channel
+ *     instead of a queue: a channel can't flood the framework or push
+ *     another channel's crossing out, and the zone it ends in always gets
+ *     posted.
+ *   - Rate limit: after a post the channel waits ADWIN_MIN_INTERVAL_MS;
+ *     crossings meanwhile fold into the latest one (counted in Folded).
+ * =============================================================================
+ */
+#include <stdint.h>
+#include "ADWindow.h"
+
+/* ????????? Tunables ????????? */
+#define ADWIN_MIN_INTERVAL_MS  50u     /* per channel, between AD_WINDOW posts */
+
+/* ????????? Module State ????????? */
+typedef struct {
+    uint16_t lo, hi, hyst;
+    volatile uint8_t  armed;
+    volatile uint8_t  zone;         /* interrupt side */
+    volatile uint8_t  pending;      /* set by the interrupt, cleared by Next */
+    volatile uint16_t latch;        /* zone << 10 | reading, at the crossing */
+    uint8_t  postedZone;            /* main side */
+    uint8_t  held;                  /* posted at least once since Set */
+    uint32_t postedMs;
+} ADWinChan_t;
+
+static ADWinChan_t chan[ADWIN_CHANNELS];
+static uint8_t turn = 0;
+static volatile uint32_t crossings = 0;
+static volatile uint32_t foldedIsr = 0;
+static uint32_t foldedMain = 0;
+
+uint8_t ADWindow_Set(uint8_t ch, uint16_t low, uint16_t high, uint16_t hyst) {
+    if (ch >= ADWIN_CHANNELS || low > high) {
+        return 0;
+    }
+    ADWinChan_t *c = &chan[ch];
+    c->armed = 0;                   /* the interrupt leaves it alone from here */
+    c->lo = low;
+    c->hi = high;
+    c->hyst = hyst;
+    c->zone = c->postedZone = ADWIN_INSIDE;
+    c->pending = 0;
+    c->held = 0;
+    c->armed = 1;
+    return 1;
+}
+
+void ADWindow_Clear(uint8_t ch) {
+    if (ch < ADWIN_CHANNELS) {
+        chan[ch].armed = 0;
+        chan[ch].pending = 0;
+    }
+}
+
+void ADWindow_Sample(uint8_t ch, uint16_t value) {
+    if (ch >= ADWIN_CHANNELS || !chan[ch].armed) {
+        return;
+    }
+    ADWinChan_t *c = &chan[ch];
+    uint8_t z = c->zone;
+    if (z == ADWIN_BELOW && value >= c->lo + c->hyst) {
+        z = ADWIN_INSIDE;
+    } else if (z == ADWIN_ABOVE && value + c->hyst <= c->hi) {
+        z = ADWIN_INSIDE;
+    }
+    if (z == ADWIN_INSIDE) {
+        if (value < c->lo) {
+            z = ADWIN_BELOW;
+        } else if (value > c->hi) {
+            z = ADWIN_ABOVE;
+        }
+    }
+    if (z == c->zone) {
+        return;
+    }
+    c->zone = z;
+    c->latch = (uint16_t)((z << 10) | (value & 0x3FFu));
+    if (c->pending) {
+        foldedIsr++;
+    }
+    c->pending = 1;
+    crossings++;
+}
+
+uint8_t ADWindow_Next(uint32_t nowMs, uint16_t *param) {
+    for (uint8_t k = 0; k < ADWIN_CHANNELS; k++) {
+        uint8_t ch = (uint8_t)((turn + k) % ADWIN_CHANNELS);
+        ADWinChan_t *c = &chan[ch];
+        if (!c->pending || (c->held && (nowMs - c->postedMs) < ADWIN_MIN_INTERVAL_MS)) {
+            continue;
+        }
+        c->pending = 0;             /* clear first: a crossing after this re-marks it */
+        uint16_t l = c->latch;
+        uint8_t z = (uint8_t)(l >> 10);
+        if (z == c->postedZone) {   /* out and back inside the hold-off */
+            foldedMain++;
+            continue;
+        }
+        c->postedZone = z;
+        c->postedMs = nowMs;
+        c->held = 1;
+        *param = ADWIN_PARAM(ch, z, l);
+        turn = (uint8_t)(ch + 1);
+        return 1;
+    }
+    return 0;
+}
+
+uint32_t ADWindow_Crossings(void) {
+    return crossings;
+}
+
+uint32_t ADWindow_Folded(void) {
+    return foldedIsr + foldedMain;
+}
+
+/* ????????? Offline test ????????? */
+/*
+ * Build on a PC:  gcc -O2 -DADWINDOW_TEST -o adwindow ADWindow.c -lm
+ * Run:            ./adwindow      (exit status 0 = all cases pass)
+ *
+ * Runs the A/D side and the checker side on one simulated millisecond
+ * clock: readings arrive at SIM_FRAME_HZ (4x oversampled frames with 12
+ * V/W pins and the battery scanned, 9345 conversions/s / 13 / 4), each
+ * with up to SIM_NOISE counts of noise, and the checker drains every
+ * millisecond. Cases:
+ *   - slow ramps through both edges, hysteresis above the noise: exactly
+ *     one post per real crossing, all 12 channels at once;
+ *   - the same with no hysteresis: posts bounded by the rate limit;
+ *   - two 10 ms dips below the window 20 ms apart: the first is posted
+ *     both ways, the second folds into the hold-off;
+ *   - all 12 channels chattering at 100 Hz: no channel posts more often
+ *     than ADWIN_MIN_INTERVAL_MS, and every channel gets its turn.
+ * Each case then holds every signal where it ended for SIM_SETTLE_MS and
+ * checks that each channel's last post matches it. Prints the
+ * crossing-to-post latency.
+ */
+#ifdef ADWINDOW_TEST
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#define SIM_FRAME_HZ   180.0
+#define SIM_NOISE      4
+#define SIM_CH         12u
+#define SIM_LO         300u
+#define SIM_HI         700u
+#define SIM_SETTLE_MS  (2u * ADWIN_MIN_INTERVAL_MS)
+
+typedef double (*Signal_t)(uint8_t ch, double ms);
+
+typedef struct {
+    uint32_t changes[SIM_CH];   /* zone changes of the clean signal */
+    uint32_t posts[SIM_CH];
+    uint32_t minGapMs[SIM_CH];
+    uint8_t  lastZone[SIM_CH];
+    uint32_t lastMs[SIM_CH];
+    double   latSum, latMax;
+    uint32_t latN;
+} Run_t;
+
+/* Zone of the clean signal, with the same edges as the window */
+static uint8_t TrueZone(double v, uint8_t was, uint16_t hyst) {
+    ADWinZone_t z = (ADWinZone_t)was;
+    if (z == ADWIN_BELOW && v >= SIM_LO + hyst) z = ADWIN_INSIDE;
+    if (z == ADWIN_ABOVE && v + hyst <= SIM_HI) z = ADWIN_INSIDE;
+    if (z == ADWIN_INSIDE) z = (v < SIM_LO) ? ADWIN_BELOW : (v > SIM_HI) ? ADWIN_ABOVE : ADWIN_INSIDE;
+    return (uint8_t)z;
+}
+
+static void Sim(Run_t *r, Signal_t sig, uint16_t hyst, uint32_t ms) {
+    uint8_t  clean[SIM_CH];
+    double   since[SIM_CH];     /* when the clean signal last changed zone */
+    double   nextFrame = 0.0;
+    *r = (Run_t){0};
+    for (uint8_t ch = 0; ch < SIM_CH; ch++) {
+        ADWindow_Set(ch, SIM_LO, SIM_HI, hyst);
+        clean[ch] = ADWIN_INSIDE;
+        since[ch] = 0.0;
+        r->lastZone[ch] = ADWIN_INSIDE;
+        r->minGapMs[ch] = UINT32_MAX;
+    }
+    for (uint32_t t = 0; t < ms + SIM_SETTLE_MS; t++) {
+        while (nextFrame < t + 1) {
+            for (uint8_t ch = 0; ch < SIM_CH; ch++) {
+                double v = sig(ch, nextFrame < ms ? nextFrame : ms);
+                uint8_t z = TrueZone(v, clean[ch], hyst);
+                if (z != clean[ch]) { clean[ch] = z; since[ch] = nextFrame; r->changes[ch]++; }
+                v += (rand() % (2 * SIM_NOISE + 1)) - SIM_NOISE;
+                ADWindow_Sample(ch, (uint16_t)(v < 0 ? 0 : v > 1023 ? 1023 : v));
+            }
+            nextFrame += 1000.0 / SIM_FRAME_HZ;
+        }
+        uint16_t p;
+        while (ADWindow_Next(t, &p)) {
+            uint8_t ch = ADWIN_PARAM_CH(p);
+            if (r->posts[ch] && t - r->lastMs[ch] < r->minGapMs[ch]) r->minGapMs[ch] = t - r->lastMs[ch];
+            r->posts[ch]++;
+            r->lastMs[ch] = t;
+            r->lastZone[ch] = ADWIN_PARAM_ZONE(p);
+            if (ADWIN_PARAM_ZONE(p) == clean[ch]) {
+                double lat = t + 1 - since[ch];     /* drained at the end of ms t */
+                r->latSum += lat; r->latN++;
+                if (lat > r->latMax) r->latMax = lat;
+            }
+        }
+    }
+    for (uint8_t ch = 0; ch < SIM_CH; ch++) {
+        r->lastZone[ch] = (r->lastZone[ch] == clean[ch]);   /* 1 = ended right */
+    }
+}
+
+/* up through the window over 2 s and back down over 2 s, staggered */
+static double Ramp(uint8_t ch, double ms) {
+    double x = fmod(ms + 150.0 * ch + 100.0, 4000.0) / 2000.0;
+    return 100.0 + 800.0 * (x < 1.0 ? x : 2.0 - x);
+}
+
+/* inside, with two 10 ms dips below the window 20 ms apart every 500 ms */
+static double Dip(uint8_t ch, double ms) {
+    double x = fmod(ms + 37.0 * (ch + 1), 500.0);
+    return (x < 10.0 || (x >= 20.0 && x < 30.0)) ? 150.0 : 500.0;
+}
+
+/* square wave through both edges at 100 Hz */
+static double Chatter(uint8_t ch, double ms) {
+    return (fmod(ms + ch, 10.0) < 5.0) ? 200.0 : 800.0;
+}
+
+#define EXACT  UINT32_MAX - 1u    /* wantEach: one post per clean zone change */
+#define ANY    UINT32_MAX
+
+static int Report(const char *name, const Run_t *r, uint32_t wantEach, uint32_t maxEach) {
+    int ok = 1;
+    uint32_t total = 0, minGap = UINT32_MAX;
+    uint8_t  ended = 0;
+    for (uint8_t ch = 0; ch < SIM_CH; ch++) {
+        total += r->posts[ch];
+        ended += r->lastZone[ch];
+        if (r->minGapMs[ch] < minGap) minGap = r->minGapMs[ch];
+        if (wantEach == EXACT && r->posts[ch] != r->changes[ch]) ok = 0;
+        if (wantEach < EXACT && r->posts[ch] != wantEach) ok = 0;
+        if (r->posts[ch] > maxEach) ok = 0;
+    }
+    if (ended != SIM_CH) ok = 0;
+    if (minGap != UINT32_MAX && minGap < ADWIN_MIN_INTERVAL_MS) ok = 0;
+    printf("%-22s posts %5u  min gap ", name, total);
+    if (minGap == UINT32_MAX) printf("   - ms"); else printf("%4u ms", minGap);
+    printf("  latency mean %5.1f max %5.1f ms  ended right %2u/%u  %s\r\n",
+           r->latN ? r->latSum / r->latN : 0.0, r->latMax, ended, SIM_CH, ok ? "pass" : "FAIL");
+    return ok;
+}
+
+int main(void) {
+    int fails = 0;
+    Run_t r;
+    srand(1);
+
+    /* 8 s = 2 ramp cycles through both edges */
+    uint32_t c0 = ADWindow_Crossings();
+    Sim(&r, Ramp, 3 * SIM_NOISE, 8000);
+    printf("%-22s crossings latched %u\r\n", "", ADWindow_Crossings() - c0);
+    fails += !Report("ramps, hysteresis", &r, EXACT, ANY);
+
+    c0 = ADWindow_Crossings();
+    Sim(&r, Ramp, 0, 8000);
+    printf("%-22s crossings latched %u\r\n", "", ADWindow_Crossings() - c0);
+    fails += !Report("ramps, no hysteresis", &r, ANY, 8000 / ADWIN_MIN_INTERVAL_MS + 1);
+
+    /* 8 double dips: down and back up once each */
+    uint32_t f0 = ADWindow_Folded();
+    Sim(&r, Dip, 3 * SIM_NOISE, 4000);
+    printf("%-22s folded %u\r\n", "", ADWindow_Folded() - f0);
+    fails += !Report("double 10 ms dips", &r, 16, ANY);
+
+    Sim(&r, Chatter, 3 * SIM_NOISE, 2000);
+    fails += !Report("100 Hz chatter", &r, ANY, 2000 / ADWIN_MIN_INTERVAL_MS + 1);
+
+    printf("%s\r\n", fails ? "FAILED" : "all pass");
+    return fails ? 1 : 0;
+}
+#endif  /* ADWINDOW_TEST */
@@ -0,0 +1,62 @@
+/* ADWindow.h */
+
+#ifndef AD_WINDOW_H
+#define AD_WINDOW_H
+
+#include <stdint.h>
+
+/* Channels are A/D pin indices: channel n is pin (1 << n) of AD.h, so
+   AD_PORTV3 .. AD_PORTW8 are channels 0..11 */
+#define ADWIN_CHANNELS   14u
+
+/* Where a reading sits against its channel's window */
+typedef enum {
+    ADWIN_BELOW,
+    ADWIN_INSIDE,
+    ADWIN_ABOVE
+} ADWinZone_t;
+
+/* AD_WINDOW event param: channel in bits 15..12, zone in 11..10, reading in 9..0 */
+#define ADWIN_PARAM(ch, zone, value) \
+    ((uint16_t)(((ch) << 12) | ((zone) << 10) | ((value) & 0x3FFu)))
+#define ADWIN_PARAM_CH(p)     ((uint8_t)((p) >> 12))
+#define ADWIN_PARAM_PIN(p)    (1u << ((p) >> 12))          /* the AD_PORTxxx bit */
+#define ADWIN_PARAM_ZONE(p)   ((ADWinZone_t)(((p) >> 10) & 0x3u))
+#define ADWIN_PARAM_VALUE(p)  ((uint16_t)((p) & 0x3FFu))
+
+/**
+ * @brief   Watch channel 'ch' (A/D counts): a reading below 'low' is
+ *          ADWIN_BELOW, above 'high' ADWIN_ABOVE. Leaving either zone takes
+ *          'hyst' counts back past its edge. Starts in ADWIN_INSIDE. Returns
+ *          0 for a bad channel or low > high, else 1.
+ */
+uint8_t ADWindow_Set(uint8_t ch, uint16_t low, uint16_t high, uint16_t hyst);
+
+/**
+ * @brief   Stop watching 'ch' and drop any crossing not yet taken.
+ */
+void    ADWindow_Clear(uint8_t ch);
+
+/**
+ * @brief   One published reading of channel 'ch'; called from the A/D
+ *          interrupt. Latches the new zone and reading when it crosses.
+ */
+void    ADWindow_Sample(uint8_t ch, uint16_t value);
+
+/**
+ * @brief   Take one crossing to post (ADWIN_PARAM format) into '*param';
+ *          returns 1 if there was one, else 0. Channels take turns, and a
+ *          channel is held off for ADWIN_MIN_INTERVAL_MS after each post;
+ *          crossings in that time fold into the latest zone, and one that
+ *          ends back where it was last posted is not posted at all.
+ */
+uint8_t ADWindow_Next(uint32_t nowMs, uint16_t *param);
+
+/**
+ * @brief   Crossings latched and crossings folded away by the rate limit,
+ *          over all channels, since power-up.
+ */
+uint32_t ADWindow_Crossings(void);
+uint32_t ADWindow_Folded(void);
+
+#endif  /* AD_WINDOW_H */
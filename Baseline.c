@@ -0,0 +1,222 @@
+/* =============================================================================
+ * File:    Baseline.c
+ * Purpose: Empty-table range baseline for background-subtraction seat detection.
+ *
+ * Dependencies:
+ *   - none
+ *   - test build: SeatDetect.c - the harness reads scans with its loader and
+ *     runs the corrected scans through the seat detector
+ *
+ * Behavior:
+ *   - The arc is split into BASE_BIN_US wide angle bins. A baseline scan of
+ *     the empty table records the mean range seen in each bin.
+ *   - A live reading is a hit only if it differs from the baseline by more
+ *     than BASE_MARGIN_CM in its own bin and in both neighbours. Chip trays,
+ *     walls and anything else that was there when the table was empty drop
+ *     out, and a reading near a bin edge is not flagged just because the
+ *     background changes there.
+ *   - Bins are independent of the sweep step, so a coarser sweep can use the
+ *     same baseline.
+ *   - The dealer stores the bins with its seats (Baseline_Export/Import via
+ *     SeatStore), so seats found against a baseline are verified against the
+ *     same baseline after a power cycle.
+ * =============================================================================
+ */
+#include <stdint.h>
+#include "Baseline.h"
+
+/* ????????? Tunables ????????? */
+/* (the arc and bin width are in Baseline.h, for SeatStore's record) */
+/* A reading this far (cm) from the empty-table range counts as someone there */
+#define BASE_MARGIN_CM   15u
+
+/* ????????? Module State ????????? */
+/* base: baseline range per bin, in cm */
+static uint16_t base[BASE_BINS];
+static uint8_t  valid = 0;
+/* recording accumulators */
+static uint32_t sum[BASE_BINS];
+static uint8_t  cnt[BASE_BINS];
+
+static uint8_t BinOf(uint16_t pulseUs) {
+    if (pulseUs <= BASE_MIN_US) {
+        return 0;
+    }
+    uint16_t b = (pulseUs - BASE_MIN_US) / BASE_BIN_US;
+    return (b >= BASE_BINS) ? BASE_BINS - 1u : (uint8_t)b;
+}
+
+void Baseline_Begin(void) {
+    for (uint8_t b = 0; b < BASE_BINS; b++) {
+        sum[b] = 0;
+        cnt[b] = 0;
+    }
+}
+
+void Baseline_AddSample(uint16_t pulseUs, uint16_t cm) {
+    uint8_t b = BinOf(pulseUs);
+    if (cnt[b] < 0xFF) {
+        sum[b] += cm;
+        cnt[b]++;
+    }
+}
+
+uint8_t Baseline_End(void) {
+    uint8_t filled = 0;
+    for (uint8_t b = 0; b < BASE_BINS; b++) {
+        if (cnt[b]) {
+            filled++;
+        }
+    }
+    if (!filled) {
+        return 0;
+    }
+
+    /* Copy each empty bin from the nearest recorded one (ties go downward) */
+    for (uint8_t b = 0; b < BASE_BINS; b++) {
+        uint8_t src = b;
+        for (uint8_t d = 0; !cnt[src]; d++) {
+            if (b >= d && cnt[b - d]) {
+                src = b - d;
+            } else if (b + d < BASE_BINS && cnt[b + d]) {
+                src = b + d;
+            }
+        }
+        base[b] = (uint16_t)(sum[src] / cnt[src]);
+    }
+    valid = 1;
+    return filled;
+}
+
+uint8_t Baseline_IsValid(void) {
+    return valid;
+}
+
+uint8_t Baseline_Export(uint16_t *cm) {
+    for (uint8_t b = 0; b < BASE_BINS; b++) {
+        cm[b] = valid ? base[b] : 0;
+    }
+    return valid;
+}
+
+void Baseline_Import(const uint16_t *cm) {
+    for (uint8_t b = 0; b < BASE_BINS; b++) {
+        base[b] = cm[b];
+    }
+    valid = 1;
+}
+
+uint8_t Baseline_IsHit(uint16_t pulseUs, uint16_t cm) {
+    uint8_t b  = BinOf(pulseUs);
+    uint8_t lo = b ? b - 1u : b;
+    uint8_t hi = (b + 1u < BASE_BINS) ? b + 1u : b;
+    for (uint8_t i = lo; i <= hi; i++) {
+        uint16_t d = (cm > base[i]) ? cm - base[i] : base[i] - cm;
+        if (d <= BASE_MARGIN_CM) {
+            return 0;           /* matches the empty table here */
+        }
+    }
+    return 1;
+}
+
+/* ????????? Offline harness ????????? */
+/*
+ * Build on a PC:  gcc -O2 -DBASELINE_TEST -o baseline Baseline.c SeatDetect.c
+ * Run:            ./baseline [-t cm] empty.csv scan1.csv [scan2.csv ...]
+ *
+ * Scan files are read with SeatDetect_LoadScan(): "pulse,cm" per line and an
+ * optional "#truth <us> ..." line. The first file is the empty-table scan.
+ * Every later scan is segmented twice, once with the fixed -t threshold
+ * (default 30, same as NEAR_CM) and once against the baseline. The harness
+ * reports the seats found, the false seats (no truth centre within
+ * SEAT_MATCH_US) and the true seats missed by each method.
+ */
+#ifdef BASELINE_TEST
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "SeatDetect.h"
+
+#define MAX_SAMPLES    1024
+#define SEAT_MATCH_US  150u
+
+static uint16_t sPulse[MAX_SAMPLES], sCm[MAX_SAMPLES];
+static uint16_t truth[SEAT_MAX];
+
+static int LoadScan(const char *fn, int *nt) {
+    return SeatDetect_LoadScan(fn, sPulse, sCm, MAX_SAMPLES, truth, nt);
+}
+
+static uint8_t Near(uint16_t a, uint16_t b) {
+    return (uint16_t)((a > b) ? a - b : b - a) <= SEAT_MATCH_US;
+}
+
+/* Segment the loaded scan and score it against truth */
+static void Evaluate(const char *name, int n, int nt, uint16_t thresh, uint8_t useBase) {
+    int falseSeats = 0, missed = 0;
+    SeatDetect_Begin();
+    for (int i = 0; i < n; i++) {
+        uint8_t hit = useBase ? Baseline_IsHit(sPulse[i], sCm[i]) : sCm[i] >= thresh;
+        SeatDetect_AddSample(sPulse[i], sCm[i], hit);
+    }
+    int nf = SeatDetect_Finish();
+    printf("  %-9s seats=%d:", name, nf);
+    for (int i = 0; i < nf; i++) {
+        uint16_t c = SeatDetect_Get(i)->centreUs;
+        int ok = 0;
+        printf(" %u", c);
+        for (int t = 0; t < nt; t++) {
+            ok |= Near(c, truth[t]);
+        }
+        falseSeats += !ok;
+    }
+    for (int t = 0; t < nt; t++) {
+        int ok = 0;
+        for (int i = 0; i < nf; i++) {
+            ok |= Near(SeatDetect_Get(i)->centreUs, truth[t]);
+        }
+        missed += !ok;
+    }
+    if (nt) {
+        printf("  false=%d missed=%d", falseSeats, missed);
+    }
+    printf("\r\n");
+}
+
+int main(int argc, char **argv) {
+    uint16_t thresh = 30;
+    int a = 1, n, nt;
+    if (a + 1 < argc && strcmp(argv[a], "-t") == 0) {
+        thresh = (uint16_t)atoi(argv[a + 1]);
+        a += 2;
+    }
+    if (a >= argc) {
+        printf("usage: %s [-t cm] empty.csv scan.csv ...\r\n", argv[0]);
+        return 1;
+    }
+
+    n = LoadScan(argv[a], &nt);
+    if (n <= 0) {
+        printf("%s: no samples\r\n", argv[a]);
+        return 1;
+    }
+    Baseline_Begin();
+    for (int i = 0; i < n; i++) {
+        Baseline_AddSample(sPulse[i], sCm[i]);
+    }
+    printf("baseline %s: %d samples, %u of %u bins\r\n",
+           argv[a], n, Baseline_End(), (unsigned)BASE_BINS);
+
+    for (a++; a < argc; a++) {
+        n = LoadScan(argv[a], &nt);
+        if (n < 0) {
+            printf("%s: cannot open\r\n", argv[a]);
+            continue;
+        }
+        printf("%s: %d samples, truth=%d\r\n", argv[a], n, nt);
+        Evaluate("threshold", n, nt, thresh, 0);
+        Evaluate("baseline", n, nt, thresh, 1);
+    }
+    return 0;
+}
+#endif  /* BASELINE_TEST */
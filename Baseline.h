@@ -0,0 +1,58 @@
+/* Baseline.h */
+
+#ifndef BASELINE_H
+#define BASELINE_H
+
+#include <stdint.h>
+
+/* Servo arc covered by the baseline (same as the dealer's MIN/MAX_PULSE_US) */
+#define BASE_MIN_US      1000u
+#define BASE_MAX_US      2500u
+/* Width of one angle bin, in us of pulse width */
+#define BASE_BIN_US      50u
+
+#define BASE_BINS        ((BASE_MAX_US - BASE_MIN_US) / BASE_BIN_US + 1u)
+
+/**
+ * @brief   Start recording an empty-table scan. The old baseline stays in
+ *          use until Baseline_End() replaces it.
+ */
+void     Baseline_Begin(void);
+
+/**
+ * @brief   Add one sample of the empty-table scan to its angle bin.
+ */
+void     Baseline_AddSample(uint16_t pulseUs, uint16_t cm);
+
+/**
+ * @brief   Finish the recording: each bin becomes the mean of its samples and
+ *          bins the scan never reached copy their nearest recorded neighbour.
+ * @return  Number of bins that got samples (0 leaves the old baseline as is).
+ */
+uint8_t  Baseline_End(void);
+
+/**
+ * @brief   Returns 1 once a baseline has been recorded.
+ */
+uint8_t  Baseline_IsValid(void);
+
+/**
+ * @brief   Copy the baseline (BASE_BINS ranges in cm) into cm, for storing.
+ * @return  1 if there is one, else 0 (cm is zeroed).
+ */
+uint8_t  Baseline_Export(uint16_t *cm);
+
+/**
+ * @brief   Use the BASE_BINS ranges in cm, as saved by Baseline_Export(), as
+ *          the baseline.
+ */
+void     Baseline_Import(const uint16_t *cm);
+
+/**
+ * @brief   Background subtraction: 1 if cm departs from the empty-table range
+ *          at this angle (and at both neighbouring bins) by more than
+ *          BASE_MARGIN_CM. Only meaningful when Baseline_IsValid().
+ */
+uint8_t  Baseline_IsHit(uint16_t pulseUs, uint16_t cm);
+
+#endif  /* BASELINE_H */
@@ -0,0 +1,206 @@
+/* =============================================================================
+ * File:    BatComp.c
+ * Purpose: Battery-voltage feed-forward: scale the motor duty so the same
+ *          command gives the same drive on a full or a tired pack.
+ *
+ * Dependencies:
+ *   - BatMonitor.h   - BATMON_NO_PACK_MV, the no-pack threshold
+ *   - test build: RampShape.c - the drive ramp of the simulated fling
+ *
+ * Behavior:
+ *   - The motor's drive goes with duty x battery voltage. The duty gain is
+ *     BATCOMP_NOM_MV / battery, so a full pack is turned down to what the
+ *     motor would get at BATCOMP_NOM_MV. Below BATCOMP_NOM_MV a duty of 1000
+ *     can't be raised any further; pick the nominal near the bottom of the
+ *     pack's useful range so there is headroom almost to the end.
+ *   - Gains stay inside BATCOMP_GAIN_MIN..BATCOMP_GAIN_MAX, so a bad reading
+ *     can only move the duty so far.
+ *   - The voltage should be taken with the motor off: under load the pack
+ *     sags, and compensating the sag would feed back on itself.
+ *   - BatComp_SpeedScale() is the other way round (battery / nominal), for
+ *     anything whose speed simply follows the pack, such as a servo powered
+ *     from it.
+ * =============================================================================
+ */
+#include <stdint.h>
+#include "BatComp.h"
+#include "BatMonitor.h"
+
+/* ????????? Tunables ????????? */
+/* Voltage the motor is compensated to (3S LiFePO4, near the knee) */
+#define BATCOMP_NOM_MV    9000u
+/* Gain limits, x BATCOMP_ONE */
+#define BATCOMP_GAIN_MIN  768u      /* 0.75: pack up to 12.0 V */
+#define BATCOMP_GAIN_MAX  1331u     /* 1.30: pack down to 6.9 V */
+#define BATCOMP_DUTY_MAX  1000u     /* MAX_PWM */
+
+/* ????????? Module State ????????? */
+static uint8_t  enabled = 0;
+static uint16_t lastMv = BATCOMP_NOM_MV;
+static uint16_t gain = BATCOMP_ONE;
+static uint16_t speed = BATCOMP_ONE;
+
+static uint16_t Clamp(uint32_t g) {
+    if (g < BATCOMP_GAIN_MIN) return BATCOMP_GAIN_MIN;
+    if (g > BATCOMP_GAIN_MAX) return BATCOMP_GAIN_MAX;
+    return (uint16_t)g;
+}
+
+static void Recalc(void) {
+    if (!enabled) {
+        gain = speed = BATCOMP_ONE;
+        return;
+    }
+    gain  = Clamp(((uint32_t)BATCOMP_NOM_MV * BATCOMP_ONE + lastMv / 2u) / lastMv);
+    speed = (uint16_t)(((uint32_t)BATCOMP_ONE * BATCOMP_ONE + gain / 2u) / gain);
+}
+
+void BatComp_Enable(uint8_t on) {
+    enabled = on;
+    Recalc();
+}
+
+void BatComp_Update(uint16_t mv) {
+    if (mv < BATMON_NO_PACK_MV) {
+        return;
+    }
+    lastMv = mv;
+    Recalc();
+}
+
+uint16_t BatComp_Duty(uint16_t duty) {
+    uint32_t d = ((uint32_t)duty * gain + BATCOMP_ONE / 2u) / BATCOMP_ONE;
+    return (d > BATCOMP_DUTY_MAX) ? BATCOMP_DUTY_MAX : (uint16_t)d;
+}
+
+uint16_t BatComp_Gain(void) {
+    return gain;
+}
+
+uint16_t BatComp_SpeedScale(void) {
+    return speed;
+}
+
+/* ????????? Offline simulation ????????? */
+/*
+ * Build on a PC:  gcc -O2 -DBATCOMP_TEST -o batcomp BatComp.c RampShape.c -lm
+ * Run:            ./batcomp
+ *
+ * Flings one card at each point of a 3S LiFePO4 discharge curve (rest
+ * voltage against state of charge, from full down to about the critical
+ * level in BatMonitor.c), with the motor model of RampShape.c's simulation
+ * (same constants, 40 ms Ramp_Exp soft start, fixed card drag) at DUTY_FAST:
+ *   - raw:  duty 1000 whatever the pack;
+ *   - comp: BatComp_Duty(1000) from the rest voltage as the filtered A/D
+ *     would report it (10:1 divider, 10-bit, 3.3 V reference).
+ * Prints the time to exit and the roller surface speed at exit for each
+ * point, then the spread (max - min) and coefficient of variation of the
+ * exit time over the points down to BATCOMP_NOM_MV (where compensation
+ * still has headroom) and over the whole curve. The curve and motor
+ * constants are assumptions, not measurements of this pack.
+ */
+#ifdef BATCOMP_TEST
+#include <stdio.h>
+#include <math.h>
+#include "RampShape.h"
+
+#define SIM_DT        1e-4
+#define SIM_PWM_S     1e-3
+#define SIM_RBAT      0.35
+#define SIM_R         3.0
+#define SIM_K         0.30
+#define SIM_J         8e-4
+#define SIM_B         2e-3
+#define SIM_LOAD      0.15
+#define SIM_RADIUS    0.012
+#define SIM_EXIT_MM   60.0
+#define SIM_RAMP_MS   40u
+
+/* state of charge (%), rest voltage (V) */
+static const double curve[][2] = {
+    {100, 10.80}, {95, 10.20}, {90, 10.05}, {80, 9.99}, {70, 9.96},
+    {60, 9.93}, {50, 9.90}, {40, 9.87}, {30, 9.81}, {20, 9.72},
+    {15, 9.60}, {10, 9.30}, {7, 9.00}, {5, 8.85}, {3, 8.70}, {1, 8.55}
+};
+#define SIM_POINTS (sizeof curve / sizeof curve[0])
+
+typedef struct {
+    double exitMs, mmps;
+} Fling_t;
+
+/* Rest voltage as the filtered A/D reading, in mV */
+static uint16_t AdMv(double v) {
+    unsigned counts = (unsigned)(v / 10.0 / 3.3 * 1023.0 + 0.5);
+    return (uint16_t)(counts * 33000u / 1023u);
+}
+
+static Fling_t Fling(double cell, uint16_t target) {
+    Fling_t r = {0, 0};
+    double w = 0, theta = 0, t = 0, duty = 0, nextTick = 0;
+    double exitRad = SIM_EXIT_MM / 1000.0 / SIM_RADIUS;
+    uint32_t tick = 0;
+    while (theta < exitRad && t < 2.0) {
+        if (t >= nextTick) {
+            duty = Ramp_At(&Ramp_Exp, 0, target, tick, SIM_RAMP_MS) / 1000.0;
+            tick++;
+            nextTick += SIM_PWM_S;
+        }
+        double i = (duty * cell - SIM_K * w) / (SIM_R + duty * SIM_RBAT);
+        if (i < 0) i = 0;
+        double torque = SIM_K * i - SIM_B * w - (w > 0 || SIM_K * i > SIM_LOAD ? SIM_LOAD : SIM_K * i);
+        w += torque / SIM_J * SIM_DT;
+        if (w < 0) w = 0;
+        theta += w * SIM_DT;
+        t += SIM_DT;
+    }
+    r.exitMs = t * 1000.0;
+    r.mmps = w * SIM_RADIUS * 1000.0;   /* roller surface speed */
+    return r;
+}
+
+typedef struct {
+    double lo, hi, s, s2;
+    int n;
+} Spread_t;
+
+static void Add(Spread_t *s, double x) {
+    if (s->n == 0 || x < s->lo) s->lo = x;
+    if (s->n == 0 || x > s->hi) s->hi = x;
+    s->s += x;
+    s->s2 += x * x;
+    s->n++;
+}
+
+static void Print(const char *name, const Spread_t *s) {
+    double mean = s->s / s->n;
+    double cv = sqrt(s->s2 / s->n - mean * mean) / mean;
+    printf("%-26s mean %6.1f ms  spread %5.1f ms  cv %4.1f%%\r\n",
+           name, mean, s->hi - s->lo, 100.0 * cv);
+}
+
+int main(void) {
+    Spread_t rawHead = {0}, compHead = {0}, rawAll = {0}, compAll = {0};
+    BatComp_Enable(1);
+    printf("soc%%  Vrest  duty  raw_exit_ms  comp_exit_ms  raw_mm/s  comp_mm/s\r\n");
+    for (unsigned k = 0; k < SIM_POINTS; k++) {
+        double v = curve[k][1];
+        BatComp_Update(AdMv(v));
+        uint16_t duty = BatComp_Duty(1000);
+        Fling_t raw = Fling(v, 1000);
+        Fling_t comp = Fling(v, duty);
+        printf("%4.0f  %5.2f  %4u  %11.1f  %12.1f  %8.0f  %9.0f\r\n",
+               curve[k][0], v, duty, raw.exitMs, comp.exitMs, raw.mmps, comp.mmps);
+        Add(&rawAll, raw.exitMs);
+        Add(&compAll, comp.exitMs);
+        if (v * 1000.0 >= BATCOMP_NOM_MV) {
+            Add(&rawHead, raw.exitMs);
+            Add(&compHead, comp.exitMs);
+        }
+    }
+    Print("raw, down to nominal", &rawHead);
+    Print("comp, down to nominal", &compHead);
+    Print("raw, whole curve", &rawAll);
+    Print("comp, whole curve", &compAll);
+    return 0;
+}
+#endif  /* BATCOMP_TEST */
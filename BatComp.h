@@ -0,0 +1,41 @@
+/* BatComp.h */
+
+#ifndef BAT_COMP_H
+#define BAT_COMP_H
+
+#include <stdint.h>
+
+/* Unity gain for BatComp_Gain() and BatComp_SpeedScale() */
+#define BATCOMP_ONE      1024u
+
+/**
+ * @brief   Turn compensation on or off. Off (the default) holds both gains
+ *          at BATCOMP_ONE.
+ */
+void     BatComp_Enable(uint8_t on);
+
+/**
+ * @brief   New battery voltage (mV), filtered and taken with the motor off.
+ *          Readings below BATMON_NO_PACK_MV (no pack, running off USB) are
+ *          ignored.
+ */
+void     BatComp_Update(uint16_t mv);
+
+/**
+ * @brief   'duty' (0..1000) scaled so the motor sees the voltage it would at
+ *          BATCOMP_NOM_MV, within the gain limits and never above 1000.
+ */
+uint16_t BatComp_Duty(uint16_t duty);
+
+/**
+ * @brief   Duty gain now in use, x BATCOMP_ONE (nominal / battery, clamped).
+ */
+uint16_t BatComp_Gain(void);
+
+/**
+ * @brief   Battery / nominal, x BATCOMP_ONE (clamped): how fast a motor run
+ *          straight off the pack turns compared with nominal.
+ */
+uint16_t BatComp_SpeedScale(void);
+
+#endif  /* BAT_COMP_H */
@@ -0,0 +1,221 @@
+/* =============================================================================
+ * File:    BatMonitor.c
+ * Purpose: Grade the battery's rest voltage as OK, low or critical, without
+ *          chattering when it sits on a threshold.
+ *
+ * Dependencies:
+ *   - none; BatteryService.c feeds it and posts the grade events
+ *
+ * Behavior:
+ *   - Each grade is entered below one voltage and left above a higher one
+ *     (BATMON_x_MV / BATMON_x_CLEAR_MV), so noise of less than the gap
+ *     can't flip it back and forth.
+ *   - A new grade only takes effect after BATMON_CONFIRM readings in a row
+ *     agree on it, so a single bad reading does nothing.
+ *   - Either direction can skip a grade: a sudden drop goes straight to
+ *     critical, a fresh pack straight back to OK.
+ *   - Readings below BATMON_NO_PACK_MV mean there is no pack (USB power
+ *     only) and are ignored, as the old lockout in AD.c did.
+ * =============================================================================
+ */
+#include <stdint.h>
+#include "BatMonitor.h"
+
+/* ????????? Tunables ????????? */
+/* 3S LiFePO4 rest voltages (mV). Low is at the knee of the curve; critical
+   is the old 8.48 V lockout of AD.c */
+#define BATMON_LOW_MV          9000u
+#define BATMON_LOW_CLEAR_MV    9300u
+#define BATMON_CRIT_MV         8500u
+#define BATMON_CRIT_CLEAR_MV   8800u
+#define BATMON_CONFIRM         3u
+/* (BATMON_NO_PACK_MV is in BatMonitor.h, shared with BatComp) */
+
+/* ????????? Module State ????????? */
+static BatLevel_t level = BATMON_OK;
+static BatLevel_t seen = BATMON_OK;     /* grade the last readings point to */
+static uint8_t    seenN = 0;
+
+/* Grade 'mv' points to, given the grade now in force */
+static BatLevel_t Target(uint16_t mv) {
+    switch (level) {
+    case BATMON_OK:
+        if (mv < BATMON_CRIT_MV) return BATMON_CRITICAL;
+        if (mv < BATMON_LOW_MV)  return BATMON_LOW;
+        return BATMON_OK;
+    case BATMON_LOW:
+        if (mv < BATMON_CRIT_MV)       return BATMON_CRITICAL;
+        if (mv >= BATMON_LOW_CLEAR_MV) return BATMON_OK;
+        return BATMON_LOW;
+    default:
+        if (mv >= BATMON_LOW_CLEAR_MV)  return BATMON_OK;
+        if (mv >= BATMON_CRIT_CLEAR_MV) return BATMON_LOW;
+        return BATMON_CRITICAL;
+    }
+}
+
+void BatMonitor_Reset(void) {
+    level = seen = BATMON_OK;
+    seenN = 0;
+}
+
+uint8_t BatMonitor_Update(uint16_t mv) {
+    if (mv < BATMON_NO_PACK_MV) {
+        return 0;
+    }
+    BatLevel_t t = Target(mv);
+    if (t == level) {
+        seenN = 0;
+        return 0;
+    }
+    if (t != seen) {
+        seen = t;
+        seenN = 0;
+    }
+    if (++seenN < BATMON_CONFIRM) {
+        return 0;
+    }
+    level = t;
+    seenN = 0;
+    return 1;
+}
+
+BatLevel_t BatMonitor_Level(void) {
+    return level;
+}
+
+/* ????????? Offline test ????????? */
+/*
+ * Build on a PC:  gcc -O2 -DBATMON_TEST -o batmon BatMonitor.c -lm
+ * Run:            ./batmon        (exit status 0 = all cases pass)
+ *
+ * Feeds BatMonitor a simulated voltage source the way BatteryService reads
+ * it: rest voltage plus noise (SIM_NOISE_MV peak), through the 10:1
+ * divider and 10-bit A/D (about 32 mV a count), one reading per sample.
+ * Each case prints the grade changes it saw and checks them:
+ *   - slow discharge from full to flat: OK -> LOW -> CRITICAL, once each;
+ *   - a pack resting on each threshold: no change back and forth;
+ *   - one-sample dips (a reading under load slipping in): no change;
+ *   - no pack (USB power): ignored;
+ *   - a fresh pack after critical: straight back to OK.
+ * Also prints how often the grade would have flipped on the same noisy
+ * readings with plain thresholds (no hysteresis, no confirmation).
+ */
+#ifdef BATMON_TEST
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#define SIM_NOISE_MV   60.0
+#define SIM_SAMPLES    2000
+
+static const char *Name(BatLevel_t l) {
+    return (l == BATMON_OK) ? "OK" : (l == BATMON_LOW) ? "LOW" : "CRITICAL";
+}
+
+/* Voltage as the filtered A/D would report it, in mV */
+static uint16_t AdMv(double mv) {
+    mv += SIM_NOISE_MV * (2.0 * rand() / (double)RAND_MAX - 1.0);
+    if (mv < 0) mv = 0;
+    unsigned counts = (unsigned)(mv / 10.0 / 3300.0 * 1023.0 + 0.5);
+    return (uint16_t)(counts * 33000u / 1023u);
+}
+
+/* Plain thresholds: the grade straight from one reading */
+static BatLevel_t Plain(uint16_t mv) {
+    if (mv < BATMON_CRIT_MV) return BATMON_CRITICAL;
+    if (mv < BATMON_LOW_MV)  return BATMON_LOW;
+    return BATMON_OK;
+}
+
+typedef struct {
+    uint16_t   changes;
+    uint16_t   plainFlips;
+    BatLevel_t path[8];
+} Run_t;
+
+static void Feed(Run_t *r, uint16_t mv, BatLevel_t *plain) {
+    if (BatMonitor_Update(mv)) {
+        if (r->changes < 8) r->path[r->changes] = BatMonitor_Level();
+        r->changes++;
+    }
+    if (mv >= BATMON_NO_PACK_MV) {
+        BatLevel_t p = Plain(mv);
+        if (p != *plain) r->plainFlips++;
+        *plain = p;
+    }
+}
+
+static int Check(const char *name, const Run_t *r, uint16_t want, const BatLevel_t *path) {
+    int ok = (r->changes == want);
+    printf("%-26s changes %3u  plain flips %4u  path OK", name, r->changes, r->plainFlips);
+    for (uint16_t k = 0; k < r->changes && k < 8; k++) {
+        printf(" -> %s", Name(r->path[k]));
+        if (k < want && r->path[k] != path[k]) ok = 0;
+    }
+    printf("  %s\r\n", ok ? "pass" : "FAIL");
+    return ok;
+}
+
+int main(void) {
+    int fails = 0;
+    Run_t r;
+    BatLevel_t plain;
+    srand(1);
+
+    /* full to flat */
+    {
+        static const BatLevel_t want[] = {BATMON_LOW, BATMON_CRITICAL};
+        BatMonitor_Reset(); plain = BATMON_OK; r = (Run_t){0};
+        for (int k = 0; k < SIM_SAMPLES; k++) {
+            Feed(&r, AdMv(10800.0 - 2600.0 * k / SIM_SAMPLES), &plain);
+        }
+        fails += !Check("discharge 10.8 -> 8.2 V", &r, 2, want);
+    }
+    /* sitting on the low threshold, then on the critical one */
+    {
+        static const BatLevel_t want[] = {BATMON_LOW};
+        BatMonitor_Reset(); plain = BATMON_OK; r = (Run_t){0};
+        for (int k = 0; k < SIM_SAMPLES; k++) {
+            Feed(&r, AdMv(BATMON_LOW_MV), &plain);
+        }
+        fails += !Check("resting at low level", &r, 1, want);
+    }
+    {
+        static const BatLevel_t want[] = {BATMON_LOW, BATMON_CRITICAL};
+        BatMonitor_Reset(); plain = BATMON_OK; r = (Run_t){0};
+        for (int k = 0; k < SIM_SAMPLES; k++) {
+            Feed(&r, AdMv(BATMON_CRIT_MV + (k < 10 ? 300 : 0)), &plain);
+        }
+        fails += !Check("resting at critical level", &r, 2, want);
+    }
+    /* one low reading in every ten, on a healthy pack */
+    {
+        BatMonitor_Reset(); plain = BATMON_OK; r = (Run_t){0};
+        for (int k = 0; k < SIM_SAMPLES; k++) {
+            Feed(&r, AdMv(k % 10 == 5 ? 8000.0 : 9900.0), &plain);
+        }
+        fails += !Check("one-sample dips to 8.0 V", &r, 0, NULL);
+    }
+    /* USB power only */
+    {
+        BatMonitor_Reset(); plain = BATMON_OK; r = (Run_t){0};
+        for (int k = 0; k < SIM_SAMPLES; k++) {
+            Feed(&r, AdMv(k < SIM_SAMPLES / 2 ? 4500.0 : 200.0), &plain);
+        }
+        fails += !Check("no pack", &r, 0, NULL);
+    }
+    /* flat pack swapped for a full one */
+    {
+        static const BatLevel_t want[] = {BATMON_CRITICAL, BATMON_OK};
+        BatMonitor_Reset(); plain = BATMON_OK; r = (Run_t){0};
+        for (int k = 0; k < SIM_SAMPLES; k++) {
+            double v = (k < SIM_SAMPLES / 2) ? 8200.0 : (k < SIM_SAMPLES / 2 + 5) ? 0.0 : 10700.0;
+            Feed(&r, AdMv(v), &plain);
+        }
+        fails += !Check("pack swap", &r, 2, want);
+    }
+    printf("%s\r\n", fails ? "FAILED" : "all pass");
+    return fails ? 1 : 0;
+}
+#endif  /* BATMON_TEST */
@@ -0,0 +1,36 @@
+/* BatMonitor.h */
+
+#ifndef BAT_MONITOR_H
+#define BAT_MONITOR_H
+
+#include <stdint.h>
+
+/* Battery readings (mV) below this are not a pack: the board is running off
+   USB. The old AD.c lockout's NO_BAT level; BatComp ignores them too */
+#define BATMON_NO_PACK_MV  5450u
+
+/* Battery grades, best first */
+typedef enum {
+    BATMON_OK,
+    BATMON_LOW,         /* deal on, with the motor derated */
+    BATMON_CRITICAL     /* finish the card in hand, then stop */
+} BatLevel_t;
+
+/**
+ * @brief   Back to BATMON_OK, as at power-up.
+ */
+void       BatMonitor_Reset(void);
+
+/**
+ * @brief   One rest-voltage reading (mV). Returns 1 when it changes the
+ *          grade (see BatMonitor_Level()), else 0. Readings below
+ *          BATMON_NO_PACK_MV (running off USB) are ignored.
+ */
+uint8_t    BatMonitor_Update(uint16_t mv);
+
+/**
+ * @brief   Grade now in force.
+ */
+BatLevel_t BatMonitor_Level(void);
+
+#endif  /* BAT_MONITOR_H */
@@ -0,0 +1,76 @@
+/* =============================================================================
+ * File:    BatteryService.c
+ * Purpose: Battery monitoring as an ES service: the undervoltage check that
+ *          used to lock the board up inside the A/D interrupt, now graded
+ *          events the dealer can act on.
+ *
+ * Dependencies:
+ *   - AD.h         - AD_ReadBatteryMillivolts() (filtered by the A/D ISR)
+ *   - BatMonitor.h - grading with hysteresis and confirmation
+ *   - FeedMotor.h  - FeedMotor_IsResting(), so only rest voltage is graded
+ *   - ES_Framework / ES_Timers - TMR_BAT, ES_PostAll()
+ *
+ * Behavior:
+ *   - Every BAT_SAMPLE_MS, if the feed motor has been off long enough, the
+ *     filtered voltage goes to BatMonitor. Readings under load are skipped:
+ *     the sag while a card is flung would grade a good pack as low.
+ *   - A change of grade posts BAT_OK, BAT_LOW or BAT_CRITICAL to every
+ *     service with the reading in mV, and logs ,,BAT=<grade> and
+ *     ,,BAT_REST_MV.
+ *   - What to do about it (derate, stop dealing) is up to the HSM; nothing
+ *     here touches the motor or blocks.
+ * =============================================================================
+ */
+#include <stdint.h>
+#include <stdio.h>
+
+#include "ES_Configure.h"
+#include "ES_Framework.h"
+#include "ES_Timers.h"
+#include "AD.h"
+#include "BatMonitor.h"
+#include "FeedMotor.h"
+#include "BatteryService.h"
+
+/* ????????? Tunables ????????? */
+#define TMR_BAT          4      /* ES timer, posts to this service */
+#define BAT_SAMPLE_MS    100u
+
+/* ????????? Module State ????????? */
+static uint8_t MyPrio;
+
+static const char *LevelName(BatLevel_t l) {
+    return (l == BATMON_OK) ? "OK" : (l == BATMON_LOW) ? "LOW" : "CRITICAL";
+}
+
+uint8_t PostBatteryService(ES_Event e){
+    return ES_PostToService(MyPrio, e);
+}
+
+uint8_t InitBatteryService(uint8_t p){
+    MyPrio = p;
+    BatMonitor_Reset();
+    ES_Timer_InitTimer(TMR_BAT, BAT_SAMPLE_MS);
+    return 1;
+}
+
+ES_Event RunBatteryService(ES_Event ev){
+    if(ev.EventType != ES_TIMEOUT || ev.EventParam != TMR_BAT){
+        return NO_EVENT;
+    }
+    ES_Timer_InitTimer(TMR_BAT, BAT_SAMPLE_MS);
+    if(!FeedMotor_IsResting()){
+        return NO_EVENT;
+    }
+    uint16_t mv = (uint16_t)AD_ReadBatteryMillivolts();
+    if(BatMonitor_Update(mv)){
+        BatLevel_t l = BatMonitor_Level();
+        ES_Event e;
+        e.EventType  = (l == BATMON_OK) ? BAT_OK : (l == BATMON_LOW) ? BAT_LOW : BAT_CRITICAL;
+        e.EventParam = mv;
+        printf(",,BAT=%s\r\n", LevelName(l));
+        printf(",,BAT_REST_MV=%u\r\n", mv);
+        ES_PostAll(e);
+    }
+    return NO_EVENT;
+}
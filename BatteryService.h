@@ -0,0 +1,24 @@
+/* BatteryService.h */
+
+#ifndef BATTERY_SERVICE_H
+#define BATTERY_SERVICE_H
+
+#include "ES_Framework.h"
+#include <stdint.h>
+
+/* ------------ public prototypes ---------------- */
+/**
+ * @brief   Start reading the battery every BAT_SAMPLE_MS on TMR_BAT.
+ *          AD_Init() (BOARD_Init) and FeedMotor_Init() must have run.
+ */
+uint8_t    InitBatteryService(uint8_t priority);
+uint8_t    PostBatteryService(ES_Event ThisEvent);
+
+/**
+ * @brief   Grades each rest-voltage reading with BatMonitor and posts
+ *          BAT_OK, BAT_LOW or BAT_CRITICAL (param = mV) to every service
+ *          when the grade changes.
+ */
+ES_Event   RunBatteryService(ES_Event ThisEvent);
+
+#endif  /* BATTERY_SERVICE_H */
@@ -11,25 +11,65 @@
 #include "HCSR04.h"
 #include "IO_Ports.h"
 #include "RC_Servo.h"
+#include "ServoMotion.h"
+#include "SeatDetect.h"
+#include "Baseline.h"
+#include "SeatStore.h"
+#include "SeatTrack.h"
+#include "SeatTable.h"
+#include "DealPlan.h"
+#include "Encoder.h"
+#include "JamRecovery.h"
+#include "MotorTune.h"
+#include "FeedMotor.h"
+#include "SpeedCtl.h"
+#include "BatComp.h"
+#include "MotorCurrent.h"
+#include "AD.h"
 #include "pwm.h"
 #include "ES_Framework.h"
 #include "ES_Timers.h"
 
 /* ????????? Tunables ????????? */
-/* Maximum number of players the HSM will track */
-#define MAX_PLAYERS      4
-/* Minimum separation (in microseconds of pulse width) between detected players,
-   to prevent false duplicates when the sonar sees the same player multiple times */
-#define MIN_SEP_US       250u
-/* Number of initial steps during calibration in which sonar readings are ignored
-   (warming up the sensor and servo) */
+/* Maximum number of players the HSM will track (at most SEAT_TABLE_MAX) */
+#define MAX_PLAYERS      SEAT_TABLE_MAX
+/* Number of heartbeats at the start of calibration in which the servo holds at
+   MIN_PULSE_US and sonar readings are ignored (warming up the sensor and servo) */
 #define WARMUP_STEPS     10
 /* Milliseconds between each servo step during a sweep */
 #define STEP_MS          70u
 /* Microseconds increment for each servo step pulse width when sweeping */
 #define STEP_US          20u
-/* Delay (ms) between stopping the sweep and starting a motor action (deal) */
+/* Coarse-to-fine calibration: a coarse pass over the whole arc in CAL_COARSE_US
+   steps finds the seats, then each seat's extent, widened by CAL_REFINE_US on
+   both sides, is swept again in CAL_FINE_US steps every CAL_FINE_MS.
+   CAL_COARSE_US == CAL_FINE_US gives the old single fine pass */
+#define CAL_COARSE_US    80u
+#define CAL_FINE_US      STEP_US
+#define CAL_FINE_MS      40u
+#define CAL_REFINE_US    100u
+/* Cold start: 1 = stream the deal, i.e. stop at each seat as soon as the coarse
+   pass closes it and deal its first card there, so that pass is also the first
+   dealing round and no refinement follows; 0 = calibrate fully, then deal */
+#define STREAM_DEAL      1
+/* Warm start: 1 = reuse the seats saved in flash after the last calibration if
+   a ping at each stored angle still sees someone there, 0 = always sweep */
+#define WARM_START       1
+/* Time (ms) to hold at a stored seat before reading the sonar; covers two
+   trigger periods so the reading was taken at this angle */
+#define VERIFY_PING_MS   70u
+/* Seat tracking while dealing: 1 = keep pinging at TRACK_PERIOD_MS, skip seats
+   that have emptied and flag new players; 0 = sonar idle after calibration */
+#define TRACK_SEATS      1
+#define TRACK_PERIOD_MS  60u
+/* Sonar trigger period for calibration and verification (full rate) */
+#define SONAR_SCAN_MS    30u
+/* Fixed delay (ms) the dealer used to wait between stopping the sweep and starting
+   a motor action (deal). The settle model now decides the wait; this is its upper
+   bound and the baseline for the WAIT_SAVED telemetry */
 #define MOTOR_DELAY_MS   800u
+/* Extra wait (ms) added on top of the servo settle model before firing */
+#define SETTLE_MARGIN_MS 20u
 /* Duration (ms) for rotating the motor in the ?reverse? (deal-eject) direction */
 #define MOTOR_FWD_MS     350u                 /* FastRev duration (deal)  */
 /* Duration (ms) for rotating the motor in the opposite (forward) direction,
@@ -38,11 +78,85 @@
 /* Duration (ms) for the small ?tuck? movement at the end of a sweep, to push
    any cards back into position before starting the next sweep/deal */
 #define NUDGE_MS         100u                 /* sweep-boundary tuck       */
+/* Motor off between the cards of a burst, so the roller has spun down from
+   the tuck before the next fling and doesn't drag a second card with it */
+#define BURST_GAP_MS     120u
+/* Closed-loop ejection: 1 = the fling ends once the roller encoder has counted
+   EJECT_COUNTS edges and the tuck once it has counted LOCK_COUNTS, with
+   MOTOR_FWD_MS / MOTOR_LOCK_MS as timeouts; 0 = fixed-duration pulses.
+   The counts are per roller revolution of the encoder fitted; set them from
+   the ,,EJECT_CNT logged on timed-out pulses. They must differ: the event
+   parameter tells a late fling event from the tuck's */
+#define ENCODER_DEAL     1
+/* Jam recovery (needs ENCODER_DEAL): 1 = a stall during a fling or tuck backs
+   the roller off and retries (JamRecovery.c), going to Idle only when the
+   retries run out; 0 = stalls are ignored */
+#define JAM_RECOVERY     ENCODER_DEAL
+#define EJECT_COUNTS     24u
+#define LOCK_COUNTS      10u
+/* Self-tuning motor timing (needs ENCODER_DEAL): 1 = MOTOR_FWD_MS, MOTOR_LOCK_MS,
+   NUDGE_MS and DUTY_FAST are only the starting point; MotorTune.c fits them to
+   this unit from the encoder-timed pulses and stalls, and the result is saved
+   with the seats. 0 = the fixed values above */
+#define MOTOR_TUNE       ENCODER_DEAL
 /* PWM duty cycle used for ?fast? motor motion (~1000/1023 ? full speed) */
 #define DUTY_FAST        1000u
+/* Motor stop: 1 = brake (windings shorted) so the roller stops dead after
+   the tuck; 0 = coast to a stop as before. ,,STOP_CNT / ,,STOP_MS log the
+   roller travel after each tuck either way */
+#define MOTOR_BRAKE      1
+/* Soft start (ms) for every motor start: the duty climbs from 0 along
+   MOTOR_RAMP_SHAPE (RampShape.h) instead of jumping, which cuts the inrush
+   that sags the battery under the servo and sonar. 0 = full duty at once */
+#define MOTOR_RAMP_MS    40u
+#define MOTOR_RAMP_SHAPE Ramp_Exp
+/* Speed regulation (needs ENCODER_DEAL): 1 = after the soft start the fling,
+   tuck and nudges hold the roller at SpeedCtl.c's per-phase setpoints with
+   a PID on the encoder speed, so the throw no longer follows the battery;
+   ,,SPD_DUTY logs the duty each fling ended on. 0 = open-loop duty.
+   Jam back-offs stay open loop either way */
+#define SPEED_CTL        ENCODER_DEAL
+/* Battery feed-forward: 1 = every drive duty is scaled by BatComp.c's
+   nominal / rest voltage, so DUTY_FAST (or the tuned duty) drives the roller
+   the same on a full pack as near the knee; ,,BAT_MV / ,,BAT_GAIN log it
+   after each hand. 0 = raw duty */
+#define BAT_COMP         1
+/* 1 if the servo runs straight off the pack: the settle model and seek
+   profiles then slow down with it. 0 for a servo on the 5 V regulator */
+#define BAT_COMP_SERVO   0
+/* Motor current trip (mA) on the bridge's sense resistor: FeedMotor cuts the
+   drive from the A/D interrupt as soon as a jam pulls the current up, well
+   before the encoder timeout, and a fling or tuck then recovers as from a
+   stall. ,,CUR_PEAK / ,,CUR_MEAN / ,,CUR_PROF log each fling's current.
+   Set it between the highest ,,CUR_PEAK of normal flings and the stall
+   current (pack / winding). 0 = no current sensing */
+#define CUR_TRIP_MA      2200u
+/* Battery grades from BatteryService: on BAT_LOW (or worse) every drive duty
+   is capped at BAT_LOW_DUTY to spare the pack; on BAT_CRITICAL the card in
+   hand is finished, then the hand stops, and a new one won't start until the
+   pack grades LOW or OK again */
+#define BAT_LOW_DUTY     850u
+/* 1 = log the A/D interrupt rate, CPU load (per mille) and longest interrupt
+   from switch-on to the end of each hand */
+#define AD_STATS         1
 /* Watchdog timeout in milliseconds; if no sweep event arrives before this timeout,
    the HSM resets to Idle to avoid stalling */
 #define WDOG_MS          3000u
+/* Dealing motion: 1 = seek straight to the next player's angle and deal on
+   arrival, 0 = legacy STEP_US sweep across the whole arc (wraps at MAX_PULSE_US) */
+#define DEAL_SEEK        1
+/* ServoMotion profile used for seek moves (SM_STEP, SM_TRAPEZOID or SM_SCURVE) */
+#define SEEK_PROFILE     SM_TRAPEZOID
+/* Seek order: 1 = follow DealPlan (each round runs up or down the table,
+   whichever moves the servo least), 0 = ascending angle every round */
+#define DEAL_PLAN        1
+/* Pipelined tuck (seek mode only): 1 = once the card is out of the throat the
+   servo already heads for the next seat while the motor tucks, and the next
+   card fires when both are done; 0 = the servo waits for the tuck */
+#define PIPELINE_TUCK    DEAL_SEEK
+/* Stepping sweep shape: 1 = ping-pong (reverse at each end of the arc and deal to
+   players in whichever order they are crossed), 0 = wrap MAX_PULSE_US -> MIN_PULSE_US */
+#define SWEEP_PINGPONG   1
 
 /* ????????? Servo range ????????? */
 /* Minimum pulse width (in s) representing the servo?s zero/0 position */
@@ -53,11 +167,7 @@
 /* ????????? Pins ????????? */
 /* The RC servo output pin identifier */
 #define SERVO_PIN        RC_PORTY06
-/* The PWM channel used for enabling motor power */
-#define ENA_PWM_MACRO    PWM_PORTZ06
-/* Motor direction bit masks: IN1 (bit 4) and IN2 (bit 5) on PORTY */
-#define IN1_MASK         PIN4
-#define IN2_MASK         PIN5
+/* Motor pins (ENA PWM, IN1/IN2) belong to FeedMotor.c */
 /* Slide-switch pin for ON/OFF control (active-LOW) */
 #define MODE_SW_PIN      PIN11
 #define PORT_SW          PORTZ
@@ -72,6 +182,10 @@
 
 /* Number of cards per player for each game mode: Blackjack=2, FiveCardDraw=5, GoFish=7 */
 static const uint8_t CardsPP[GM_COUNT] = {2, 5, 7};
+/* Cards dealt per stop at a seat for each game mode (1 = one card per visit).
+   Every seat still gets its burst before any seat gets the next one. Raise
+   only after counting double feeds at BURST_GAP_MS on the bench */
+static const uint8_t BurstCards[GM_COUNT] = {1, 1, 1};
 
 /* ????????? Helpers ????????? */
 /* SetLED: turns on/off the two status LEDs. bit0?LED_D6, bit1?LED_D7 (1 = ON, active-LOW) */
@@ -96,15 +210,19 @@ static inline const char *ModeName(GameMode_t g){
 /* Define all possible states of the hierarchical state machine */
 typedef enum {
     IdleS,             /* Waiting for switch ON */
-    CalSweepS,         /* Sweeping servo for player detection */
-    CalDelayS,         /* Delay before performing calibration deal */
-    CalRevS,           /* Motor running reverse for calibration deal */
-    CalLockS,          /* Motor running forward to lock cards after cal deal */
+    CalSweepS,         /* Sweeping servo across the arc to scan for players */
+    CalSeekS,          /* Moving to the start of the next refinement window */
+    CalRefineS,        /* Fine sweep across one refinement window */
+    WarmVerifyS,       /* Pinging each stored seat before reusing them */
     CalSweepNudgeS,    /* Tuck at end of calibration sweep before starting deals */
     DealSweepS,        /* Sweeping servo to deal cards to all players */
     DealDelayS,        /* Delay before performing a deal */
     DealRevS,          /* Motor running reverse for a deal */
     DealLockS,         /* Motor running forward to lock after a deal */
+    BurstGapS,         /* Pause between the cards of a burst at one seat */
+    StreamSeekS,       /* Streaming: moving to a seat the sweep just found */
+    StreamResumeS,     /* Streaming: returning to where the sweep stopped */
+    JamBackS,          /* Jam: backing the roller off before a retry */
     SweepNudgeS,       /* Tuck at end-of-sweep between deals */
     DonePauseS         /* All deals done; waiting for switch OFF */
 } state_t;
@@ -129,12 +247,7 @@ static void KickWatchdog(void){
 }
 
 /* ????????? Globals ????????? */
-/* Array of servo pulse widths (s) at which players were detected */
-static uint16_t playerAngle[MAX_PLAYERS];
-/* Number of cards remaining to deal to each player */
-static uint8_t  playerRemain[MAX_PLAYERS];
-/* How many players have been detected */
-static uint8_t  players = 0;
+/* Player angles, widths and cards remaining live in SeatTable */
 /* Index of the current player being dealt */
 static uint8_t  idx = 0;
 /* Current servo pulse width (in s) */
@@ -147,144 +260,649 @@ static int8_t   warmCnt = 0;
 static GameMode_t CurMode = GM_BLACKJACK;
 /* Track last debounced switch state to detect ON/OFF edges */
 static uint8_t prevSwitch = 1;
+/* Free-running time (ms) at which the dealing phase started, for DEAL_MS telemetry */
+static uint32_t dealStartMs = 0;
+/* Direction of the stepping sweep (+1 up, -1 down); only changes in ping-pong mode */
+static int8_t   sweepDir = 1;
+/* Cards dealt so far at the current stop (burst dealing) */
+static uint8_t  burstDealt = 0;
+/* When the current fling started, and running sums for the ,,EJECT_MEAN /
+   ,,EJECT_VAR summary of fling times this hand */
+static uint32_t fireStartMs = 0;
+/* When the current tuck started (MotorTune) */
+static uint32_t tuckStartMs = 0;
+/* When the last tuck stopped and the encoder count then; 0 = not measuring */
+static uint32_t stopMs = 0;
+static uint16_t stopCnt = 0;
+/* Start of the last card fired this hand, for ,,CYCLE_MS; 0 = none yet */
+static uint32_t lastFireMs = 0;
+/* Pipelined tuck: 1 once this turn has been booked and the servo sent on
+   during the tuck; 'arrived' once it has settled at the next seat, when, and
+   the settle wait ServoMotion had already spent */
+static uint8_t  turnDealt = 0;
+static uint8_t  arrived = 0;
+static uint32_t arriveMs = 0;
+static uint16_t arriveWaitMs = 0;
+static uint16_t ejectN = 0;
+static uint32_t ejectSum = 0, ejectSq = 0;
+/* 1 while BatteryService grades the pack critical: no new card is fired */
+static uint8_t  batCritical = 0;
+/* Motor phase (DealRevS or DealLockS) to retry once a jam back-off ends */
+static state_t  jamPhase = DealRevS;
+/* Current dealing round, and when it started */
+static uint8_t  dealRound = 0;
+static uint32_t roundStartMs = 0;
+/* First round the deal plan covers (1 once the sweep has dealt round 0) */
+static uint8_t  planBase = 0;
+/* Streaming deal: 1 while the calibration sweep is dealing round 0, seats
+   dealt so far, cards each got, and the pulse the sweep stopped at */
+static uint8_t  streaming = 0;
+static uint8_t  streamed = 0;
+static uint8_t  streamCards[MAX_PLAYERS];
+static uint16_t streamResumeUs = MIN_PULSE_US;
+/* 1 while the calibration sweep is recording the empty-table baseline instead
+   of looking for players (game button held when the switch goes ON) */
+static uint8_t  baseScan = 0;
+/* Step size of the first calibration pass, and when calibration started */
+static uint16_t calStepUs = CAL_COARSE_US;
+static uint32_t calStartMs = 0;
+/* Refinement windows left by the coarse pass, and the one being swept */
+static SeatWindow_t calWin[SEAT_MAX];
+static uint8_t  calWins = 0;
+static uint8_t  calWinIdx = 0;
+/* Seats loaded from flash for a warm start */
+static SeatRecord_t stored;
+/* 1 until the first card of this hand has gone out (FIRST_CARD_MS telemetry) */
+static uint8_t  firstCard = 0;
+/* Cards not dealt this hand because their seat had emptied */
+static uint8_t  skipped = 0;
+/* 1 once a new player has been seen; the stored seats are erased when the
+   motor is next stopped */
+static uint8_t  storeStale = 0;
 
 /* ????????? Motor helpers ????????? */
-/* Set PWM duty cycle for the motor enable pin */
-static inline void Duty(uint16_t d){
-    PWM_SetDutyCycle(ENA_PWM_MACRO, d);
+/* FastFwd: run motor forward at the dealing duty (DUTY_FAST, or as tuned) */
+static inline void FastFwd(void){
+    FeedMotor_Fwd(MotorTune_Get()->duty);
 }
-/* Drive motor in forward direction: IN1=1, IN2=0 */
-static inline void Fwd(void){
-    IO_PortsSetPortBits(PORTY, IN1_MASK);
-    IO_PortsClearPortBits(PORTY, IN2_MASK);
+/* FastRev: run motor reverse at the dealing duty (DUTY_FAST, or as tuned) */
+static inline void FastRev(void){
+    FeedMotor_Rev(MotorTune_Get()->duty);
 }
-/* Drive motor in reverse direction: IN1=0, IN2=1 */
-static inline void Rev(void){
-    IO_PortsClearPortBits(PORTY, IN1_MASK);
-    IO_PortsSetPortBits(PORTY, IN2_MASK);
+/* Eject / Tuck / Nudge: the motor runs of a deal, held at their speed
+   setpoints when SPEED_CTL is set, else FastRev / FastFwd */
+static inline void Eject(void){
+    if(SPEED_CTL){
+        FeedMotor_Hold(FEED_REV, SPEED_EJECT, MotorTune_Get()->duty);
+    } else {
+        FastRev();
+    }
 }
-/* FastFwd: run motor forward at full speed (duty=DUTY_FAST) */
-static inline void FastFwd(void){
-    Fwd();
-    Duty(DUTY_FAST);
+static inline void Tuck(void){
+    if(SPEED_CTL){
+        FeedMotor_Hold(FEED_FWD, SPEED_TUCK, MotorTune_Get()->duty);
+    } else {
+        FastFwd();
+    }
 }
-/* FastRev: run motor reverse at full speed (duty=DUTY_FAST) */
-static inline void FastRev(void){
-    Rev();
-    Duty(DUTY_FAST);
+static inline void Nudge(void){
+    if(SPEED_CTL){
+        FeedMotor_Hold(FEED_FWD, SPEED_NUDGE, MotorTune_Get()->duty);
+    } else {
+        FastFwd();
+    }
 }
-/* StopM: immediately stop the motor by setting duty=0 */
+/* StopM: stop the motor, braking or coasting as MOTOR_BRAKE says */
 static inline void StopM(void){
-    Duty(0);
+    if(MOTOR_BRAKE){
+        FeedMotor_Brake();
+    } else {
+        FeedMotor_Coast();
+    }
 }
 
 /* ????????? Servo helper ????????? */
 /**
  * ServoStep:
- *   - Increments the servo's pulse width by STEP_US. If it exceeds MAX_PULSE_US,
- *     wraps back to MIN_PULSE_US and returns 1 (indicating a wrap event).
+ *   - Moves the servo's pulse width by 'step' us in the sweep direction,
+ *     stopping exactly at either end of the arc.
+ *   - Wrap mode: past MAX_PULSE_US it wraps back to MIN_PULSE_US and returns 1
+ *     (indicating a wrap event) without logging.
+ *   - Ping-pong mode: at either end of the arc it reverses sweepDir, takes the
+ *     step in the new direction and returns 1 (end of a pass). No jump.
  *   - Sets the new pulse width via RC_SetPulseTime().
  *   - Prints raw and filtered sonar distances (currently identical) to console.
- *   - Returns 1 if the sweep just wrapped; else returns 0.
+ *   - Returns 1 if the sweep just wrapped or reversed; else returns 0.
  */
-static uint8_t ServoStep(void){
+static uint8_t ServoStep(uint16_t step){
+    uint8_t ends = 0;
     prevP = pulse;
-    if(pulse >= MAX_PULSE_US){
-        pulse = MIN_PULSE_US;
-        RC_SetPulseTime(SERVO_PIN, pulse);
-        return 1;  /* wrapped back to start */
+    if(SWEEP_PINGPONG){
+        if((sweepDir > 0 && pulse >= MAX_PULSE_US) ||
+           (sweepDir < 0 && pulse <= MIN_PULSE_US)){
+            sweepDir = -sweepDir;
+            ends = 1;  /* reversed at the end of the arc */
+        }
+        if(sweepDir > 0){
+            pulse = (MAX_PULSE_US - pulse > step) ? pulse + step : MAX_PULSE_US;
+        } else {
+            pulse = (pulse - MIN_PULSE_US > step) ? pulse - step : MIN_PULSE_US;
+        }
+    } else {
+        if(pulse >= MAX_PULSE_US){
+            pulse = MIN_PULSE_US;
+            RC_SetPulseTime(SERVO_PIN, pulse);
+            return 1;  /* wrapped back to start */
+        }
+        pulse = (MAX_PULSE_US - pulse > step) ? pulse + step : MAX_PULSE_US;
     }
-    pulse += STEP_US;
     RC_SetPulseTime(SERVO_PIN, pulse);
 
     /* telemetry ? output sonar raw & filtered values (same for now) */
     uint16_t cm = HCSR04_GetDistanceCm();
     printf("%u,%u,\r\n", cm, cm);
 
-    return 0;
+    return ends;
 }
 
 /**
  * Cross:
  *   - Returns true if the sweep has crossed the angle 't' between
- *     the previous pulse width 'a' and current pulse width 'b', even
- *     if wrapping occurred around MAX_PULSE_US to MIN_PULSE_US.
+ *     the previous pulse width 'a' and current pulse width 'b'.
+ *   - Wrap mode: a > b means the sweep wrapped around MAX_PULSE_US to
+ *     MIN_PULSE_US. Ping-pong mode: a > b means the sweep is moving down,
+ *     so 't' is crossed when it lies in [b, a).
  *   - Used to detect when to deal a card at a memorized angle.
  */
 static inline bool Cross(uint16_t a, uint16_t b, uint16_t t){
+    if(SWEEP_PINGPONG){
+        return (a < b && a < t && b >= t)
+            || (a > b && b <= t && a > t);
+    }
     return (a < b && a < t && b >= t)
         || (a > b && (a < t || b >= t));
 }
 
 /**
- * AllDealt:
- *   - Returns true if every player has zero cards remaining.
+ * CrossedOwed:
+ *   - Ping-pong mode: looks for a player whose angle the last step crossed and
+ *     who is still owed a card this round. That keeps the
+ *     one-card-per-player-per-round rule while the order within a round
+ *     follows the sweep direction.
+ *   - Sets idx and returns true if such a player was found.
+ */
+static bool CrossedOwed(void){
+    for(uint16_t m = SeatTable_OwedMask(); m; m &= m - 1){
+        uint8_t i = (uint8_t)__builtin_ctz(m);
+        if(Cross(prevP, pulse, SeatTable_Angle(i))){
+            idx = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * CountRound:
+ *   - Called after each deal or skip with SeatTable's answer to whether that
+ *     finished the round; logs the round time and starts timing the next.
+ */
+static void CountRound(uint8_t roundDone){
+    if(roundDone){
+        uint32_t now = ES_Timer_GetTime();
+        printf(",,ROUND_MS=%lu\r\n", (unsigned long)(now - roundStartMs));
+        roundStartMs = now;
+        dealRound++;
+    }
+}
+
+/* PlanMoveMs: seek-move time model handed to DealPlan */
+static uint16_t PlanMoveMs(uint16_t distUs){
+    return ServoMotion_MoveMs(distUs, SEEK_PROFILE);
+}
+
+/**
+ * NextSeat:
+ *   - Seat to deal after 'from': the next one along the planned direction of
+ *     the current round in seek mode, else the next in angle order.
+ */
+static uint8_t NextSeat(uint8_t from){
+    if(DEAL_SEEK && DEAL_PLAN){
+        return SeatTable_FirstOwed(DealPlan_Dir(dealRound - planBase));
+    }
+    return SeatTable_Next(from);
+}
+
+/**
+ * IsSeatHit:
+ *   - Seat test for a range taken at the current pulse: background
+ *     subtraction once a baseline exists, else the DIST_NEAR threshold.
+ */
+static inline uint8_t IsSeatHit(uint16_t cm){
+    return Distance_IsSeatHit(pulse, cm);
+}
+
+/**
+ * FlushStore:
+ *   - Once a new player has been seen, clears the stored seats so the next
+ *     switch-on calibrates from scratch. The motor tuning stays.
+ *   - Otherwise saves the motor tuning if it has drifted far enough from the
+ *     stored copy. Call only with the motor stopped: the erase stalls the CPU.
+ */
+static void FlushStore(void){
+    if(storeStale){
+        storeStale = 0;
+        stored.count = 0;
+        stored.tune = *MotorTune_Get();
+        SeatStore_Save(&stored);
+        puts(",,STORE=0");
+    } else if(MOTOR_TUNE && MotorTune_NeedsSave(&stored.tune)){
+        stored.tune = *MotorTune_Get();
+        printf(",,TUNE_STORE=%u\r\n", SeatStore_Save(&stored));
+    }
+}
+
+/**
+ * StopTracking:
+ *   - Ends seat tracking and puts the sonar back to its full rate.
+ */
+static void StopTracking(void){
+    SeatTrack_End();
+    HCSR04_SetPeriodMs(SONAR_SCAN_MS);
+}
+
+/* AddSeat: puts one seat SeatDetect found into the seat table and logs it */
+static void AddSeat(const Seat_t *s){
+    uint8_t j = SeatTable_Add(s->centreUs, s->widthUs);
+    printf(",,PLAYER%u=%u\r\n", j+1, s->centreUs);
+    printf(",,P%u_WIDTH=%u\r\n", j+1, s->widthUs);
+    printf(",,P%u_CONF=%u\r\n", j+1, s->confidence);
+}
+
+/**
+ * TakeSeats:
+ *   - Ends the calibration scan and puts the seats SeatDetect found into the
+ *     seat table, up to MAX_PLAYERS. Seats a streaming sweep already added
+ *     are kept; only the ones after them are new.
  */
-static inline bool AllDealt(void){
-    for(uint8_t i=0; i<players; i++){
-        if(playerRemain[i]) return false;
+static void TakeSeats(void){
+    uint8_t n = SeatDetect_Finish();
+    for(uint8_t i=SeatTable_Count(); i<n && SeatTable_Count() < MAX_PLAYERS; i++){
+        AddSeat(SeatDetect_Get(i));
     }
-    return true;
 }
 
 /**
- * AdvanceIdx:
- *   - Increment idx mod players, skipping any entries where playerRemain==0.
- *   - Prepares idx for the next player in round-robin dealing.
+ * StreamNext:
+ *   - Streaming deal: if the sweep has closed a seat that hasn't had its
+ *     first card yet, adds it to the seat table, stops the sweep and seeks
+ *     back to it. Returns 1 if it did, 0 if every seat so far has a card.
  */
-static void AdvanceIdx(void){
-    do {
-        idx = (idx + 1) % players;
-    } while(playerRemain[idx] == 0);
+static uint8_t StreamNext(void){
+    if(!streaming || streamed >= SeatDetect_Count() || streamed >= MAX_PLAYERS){
+        return 0;
+    }
+    AddSeat(SeatDetect_Get(streamed));
+    idx = streamed++;
+    ES_Timer_StopTimer(TMR_SWEEP);
+    ServoMotion_MoveTo(SeatTable_Angle(idx), SEEK_PROFILE);
+    KickWatchdog();
+    State = StreamSeekS;
+    return 1;
+}
+
+/**
+ * StartRefine:
+ *   - Moves the servo to the start of refinement window calWinIdx; the fine
+ *     sweep starts once it has settled there.
+ */
+static void StartRefine(void){
+    ES_Timer_StopTimer(TMR_SWEEP);
+    ServoMotion_MoveTo(calWin[calWinIdx].loUs, SEEK_PROFILE);
+    KickWatchdog();
+    State = CalSeekS;
 }
 
 /**
- * SortAngles:
- *   - Sorts the playerAngle[] array in ascending order, carrying along
- *     the corresponding playerRemain[] counts. This ensures the servo
- *     deals in increasing pulse-width order around the circle.
+ * ResumeDealing:
+ *   - Seek mode: starts a profiled ServoMotion move straight to the current
+ *     player. SERVO_SETTLED arrives once the servo has stopped there.
+ *   - Stepping mode: re-arms the sweep heartbeat.
  */
-static void SortAngles(void){
-    for(uint8_t i=1; i<players; i++){
-        uint16_t pa = playerAngle[i];
-        uint8_t  pr = playerRemain[i];
-        int8_t   j = i - 1;
-        while(j >= 0 && playerAngle[j] > pa){
-            playerAngle[j+1]  = playerAngle[j];
-            playerRemain[j+1] = playerRemain[j];
-            j--;
+static void ResumeDealing(void){
+    if(DEAL_SEEK){
+        ServoMotion_MoveTo(SeatTable_Angle(idx), SEEK_PROFILE);
+    } else {
+        ArmHeartbeat();
+    }
+}
+
+/**
+ * ScheduleDeal:
+ *   - Arms TMR_MOTOR so the motor fires once the servo has settled.
+ *     'settleMs' is what the settle model says is still left to wait; the
+ *     safety margin is added and the old fixed MOTOR_DELAY_MS caps it.
+ *   - 'waitedMs' is settle time already spent since the servo command stopped
+ *     changing; it only matters for the log of how much of the fixed delay
+ *     was saved.
+ */
+static void ScheduleDeal(uint16_t waitedMs, uint16_t settleMs, state_t next){
+    uint16_t wait = settleMs + SETTLE_MARGIN_MS;
+    if(waitedMs + wait > MOTOR_DELAY_MS){
+        wait = (waitedMs < MOTOR_DELAY_MS) ? MOTOR_DELAY_MS - waitedMs : 0;
+    }
+    ES_Timer_InitTimer(TMR_MOTOR, wait ? wait : 1);
+    printf(",,WAIT_SAVED=%u\r\n", MOTOR_DELAY_MS - (waitedMs + wait));
+    State = next;
+}
+
+/**
+ * LogStop:
+ *   - Roller travel after the last tuck was stopped: encoder edges and the
+ *     time to the last edge. Logged as the next card fires.
+ */
+static void LogStop(void){
+    if(stopMs){
+        uint32_t last = Motor_LastPulseMs();
+        printf(",,STOP_CNT=%u\r\n", (uint16_t)(Encoder_GetCount() - stopCnt));
+        printf(",,STOP_MS=%lu\r\n", (unsigned long)(last > stopMs ? last - stopMs : 0));
+        stopMs = 0;
+    }
+}
+
+static void GoIdle(uint8_t nudge);    /* Idle reset, below */
+
+/**
+ * FireCard:
+ *   - Flings one card with the reverse run; FeedMotor puts in the dead time
+ *     if the roller was last driven forward. The tuck follows in DealRevS.
+ *   - With the pack graded critical, goes to Idle instead.
+ */
+static void FireCard(void){
+    if(batCritical){
+        /* Pack critical: the last card is out and tucked, stop here */
+        puts(",,BAT_ABORT");
+        GoIdle(0);
+        return;
+    }
+    LogStop();
+    /* Spin motor in ?deal? direction (reverse) */
+    Eject();
+    if(ENCODER_DEAL){
+        Encoder_Arm(EJECT_COUNTS);
+    }
+    Motor_ArmStall(JAM_RECOVERY);
+    fireStartMs = ES_Timer_GetTime();
+    ES_Timer_InitTimer(TMR_MOTOR, MotorTune_Get()->fwdMs);
+    State = DealRevS;
+    puts(",,HSM=DEAL");
+}
+
+/**
+ * StartTuck:
+ *   - Runs the motor forward to lock the stack after a fling.
+ */
+static void StartTuck(void){
+    Tuck();
+    if(ENCODER_DEAL){
+        Encoder_Arm(LOCK_COUNTS);
+    }
+    Motor_ArmStall(JAM_RECOVERY);
+    tuckStartMs = ES_Timer_GetTime();
+    ES_Timer_InitTimer(TMR_MOTOR, MotorTune_Get()->lockMs);
+    State = DealLockS;
+}
+
+/* LogCycle: time from the previous card fired this hand to this one */
+static void LogCycle(void){
+    uint32_t now = ES_Timer_GetTime();
+    if(lastFireMs && !streaming){
+        printf(",,CYCLE_MS=%lu\r\n", (unsigned long)(now - lastFireMs));
+    }
+    lastFireMs = now;
+}
+
+/**
+ * EndTurn:
+ *   - Takes the cards dealt at this stop off the player's remaining count.
+ */
+static void EndTurn(void){
+    uint8_t roundDone = SeatTable_Deal(idx, burstDealt);
+    printf(",,P%u_LEFT=%u\r\n", idx+1, SeatTable_Remain(idx));
+    CountRound(roundDone);
+}
+
+/**
+ * MoveAhead:
+ *   - Called as the tuck starts with the card out of the throat. If this was
+ *     the last card at this stop, books the turn now and starts the servo
+ *     towards the next seat, so the move overlaps the tuck. The tuck's end
+ *     (DealLockS) then joins the two.
+ */
+static void MoveAhead(void){
+    uint8_t n = burstDealt + 1u;    /* cards out at this stop after the tuck */
+    if(streaming || (n < BurstCards[CurMode] && n < SeatTable_Remain(idx))){
+        return;
+    }
+    burstDealt = n;
+    EndTurn();
+    turnDealt = 1;
+    arrived = 0;
+    if(!SeatTable_AllDealt()){
+        idx = NextSeat(idx);
+        ResumeDealing();
+        KickWatchdog();
+    }
+}
+
+/**
+ * LogEject:
+ *   - Logs how long the fling ran and adds it to the hand's statistics
+ *     and to the motor tuning.
+ *     A fling the encoder didn't end also logs the count it got to.
+ */
+static void LogEject(uint8_t byEncoder){
+    uint32_t ms = ES_Timer_GetTime() - fireStartMs;
+    printf(",,EJECT_MS=%lu\r\n", (unsigned long)ms);
+    if(ENCODER_DEAL && !byEncoder){
+        printf(",,EJECT_CNT=%u\r\n", Encoder_GetCount());
+    }
+    if(SPEED_CTL){
+        printf(",,SPD_DUTY=%u\r\n", SpeedCtl_Duty());
+    }
+    if(CUR_TRIP_MA){
+        const MotorCurrentProfile_t *cur = MotorCurrent_Profile();
+        printf(",,CUR_PEAK=%u\r\n", cur->peakMa);
+        printf(",,CUR_MEAN=%u\r\n", cur->meanMa);
+        printf(",,CUR_PROF=");
+        for(uint8_t b = 0; b < cur->bins; b++){
+            printf(b ? ",%u" : "%u", cur->binMa[b]);
         }
-        playerAngle[j+1]  = pa;
-        playerRemain[j+1] = pr;
+        printf("\r\n");
+    }
+    ejectN++;
+    ejectSum += ms;
+    ejectSq  += ms * ms;
+    if(MOTOR_TUNE){
+        MotorTune_Eject((uint16_t)ms, byEncoder);
+    }
+}
+
+/* LogAdStats: A/D interrupt rate, load and longest run since switch-on.
+   The core timer runs at SYSCLK/2, which is the PB clock on this board */
+static void LogAdStats(void){
+    AD_Stats_t s;
+    uint32_t ms = ES_Timer_GetTime() - calStartMs;
+    uint32_t ticksPerMs = BOARD_GetPBClock() / 1000u;
+    AD_GetStats(&s);
+    if(!ms){
+        return;
+    }
+    printf(",,AD_ISR_HZ=%lu\r\n", (unsigned long)((uint64_t)s.Interrupts * 1000u / ms));
+    printf(",,AD_LOAD_PM=%lu\r\n",
+           (unsigned long)((uint64_t)s.BusyTicks * 1000u / ((uint64_t)ms * ticksPerMs)));
+    printf(",,AD_ISR_MAX_US=%lu\r\n", (unsigned long)(s.MaxTicks / (ticksPerMs / 1000u)));
+}
+
+/* LogEjectStats: mean and variance (ms^2) of this hand's fling times */
+static void LogEjectStats(void){
+    if(ejectN){
+        uint32_t mean = ejectSum / ejectN;
+        printf(",,EJECT_MEAN=%lu\r\n", (unsigned long)mean);
+        printf(",,EJECT_VAR=%lu\r\n", (unsigned long)(ejectSq / ejectN - mean * mean));
+    }
+}
+
+/**
+ * StartDealing:
+ *   - Gives every player all of its cards; the seat table is already in
+ *     angle order.
+ *   - The stepping sweep restarts from MIN_PULSE_US; seek mode moves on from
+ *     wherever the servo currently is.
+ */
+static void StartDealing(void){
+    if(!DEAL_SEEK && !SWEEP_PINGPONG){
+        pulse = prevP = MIN_PULSE_US;
+    }
+    SeatTable_StartHand(CardsPP[CurMode]);
+    skipped = 0;
+    dealRound = 0;
+    if(streaming){
+        /* Credit the cards dealt during the sweep. That completes round 0
+           unless the end of the arc closed one more seat, which is then
+           still owed its first card */
+        streaming = 0;
+        for(uint8_t i=0; i<streamed; i++){
+            CountRound(SeatTable_Deal(i, streamCards[i]));
+        }
+    }
+    planBase = dealRound;
+    if(DEAL_SEEK && DEAL_PLAN){
+        /* Modelled servo time for this hand, planned vs. ascending every round;
+           a round is one burst per seat */
+        uint8_t k = BurstCards[CurMode];
+        DealPlan_Build(SeatTable_Angles(), SeatTable_Count(),
+                       (CardsPP[CurMode] + k - 1) / k - planBase,
+                       ServoMotion_GetPulse(), PlanMoveMs);
+        printf(",,PLAN_MS=%lu\r\n", (unsigned long)DealPlan_PlanMs());
+        printf(",,RR_MS=%lu\r\n", (unsigned long)DealPlan_RoundRobinMs());
+    }
+    if(TRACK_SEATS){
+        /* Keep watching the seats at a lower ping rate while dealing */
+        SeatTrack_Begin(SeatTable_Angles(), SeatTable_Widths(), SeatTable_Count());
+        HCSR04_SetPeriodMs(TRACK_PERIOD_MS);
+    }
+    idx = NextSeat(SEAT_TABLE_NONE);    /* first seat of the first round */
+    dealStartMs = roundStartMs = ES_Timer_GetTime();
+    lastFireMs = 0;
+    turnDealt = 0;
+    State = DealSweepS;
+    puts(",,HSM=SWEEP");
+    ResumeDealing();
+}
+
+/**
+ * NextDeal:
+ *   - Called with the motor stopped once a player's turn is over (card dealt
+ *     or seat skipped). Finishes the hand if every card is out, otherwise
+ *     moves on to the next player.
+ */
+static void NextDeal(void){
+    if(SeatTable_AllDealt()){
+        State = DonePauseS;
+        ArmHeartbeat();  /* keep polling switch after Done */
+        KickWatchdog();
+        StopTracking();
+        FlushStore();
+        puts(",,HSM=DONE");
+        /* Total dealing time for this mode / player count */
+        printf(",,DEAL_MS=%lu\r\n",
+               (unsigned long)(ES_Timer_GetTime() - dealStartMs));
+        printf(",,SKIPPED=%u\r\n", skipped);
+        LogEjectStats();
+        if(MOTOR_TUNE){
+            printf(",,TUNE_FWD=%u\r\n", MotorTune_Get()->fwdMs);
+            printf(",,TUNE_LOCK=%u\r\n", MotorTune_Get()->lockMs);
+            printf(",,TUNE_DUTY=%u\r\n", MotorTune_Get()->duty);
+        }
+        if(BAT_COMP){
+            printf(",,BAT_MV=%u\r\n", AD_ReadBatteryMillivolts());
+            printf(",,BAT_GAIN=%u\r\n", BatComp_Gain());
+        }
+        if(AD_STATS){
+            LogAdStats();
+        }
+        /* Switch-on to last card, calibration included */
+        printf(",,HAND_MS=%lu\r\n",
+               (unsigned long)(ES_Timer_GetTime() - calStartMs));
+    } else {
+        /* Move to next player and resume dealing sweep */
+        idx = NextSeat(idx);
+        State = DealSweepS;
+        ResumeDealing();
+        KickWatchdog();
+        puts(",,HSM=SWEEP");
+    }
+}
+
+/**
+ * JoinAhead:
+ *   - Tuck over after MoveAhead(): finishes the hand, or deals as soon as the
+ *     servo has settled at the next seat (at once if it already has).
+ */
+static void JoinAhead(void){
+    turnDealt = 0;
+    KickWatchdog();
+    if(SeatTable_AllDealt()){
+        NextDeal();
+    } else if(arrived){
+        uint32_t since = ES_Timer_GetTime() - arriveMs;
+        ScheduleDeal(arriveWaitMs + (since < MOTOR_DELAY_MS ? since : MOTOR_DELAY_MS), 0,
+                     DealDelayS);
+        puts(",,HSM=DELAY");
+    } else {
+        /* Still moving: DealSweepS deals on SERVO_SETTLED */
+        State = DealSweepS;
+        puts(",,HSM=SWEEP");
     }
 }
 
 /* ????????? Idle reset ????????? */
 /**
- * ResetIdle:
+ * GoIdle:
  *   - Stops motor motion & disables sonar distance checking.
  *   - Resets servo to MIN_PULSE_US (zero/0) position.
- *   - Starts a one-time ?nudge? on the motor (FastFwd for NUDGE_MS) to
- *     push cards back into place.
+ *   - If 'nudge', starts a one-time ?nudge? on the motor (forward for the
+ *     nudge time, stopped on TMR_MOTOR) to push cards back into place.
  *   - Arms TMR_SWEEP so the HSM continues polling the slide-switch.
  *   - Turns LEDs off and prints ?,,HSM=IDLE? to console.
  */
-static void ResetIdle(void){
+static void GoIdle(uint8_t nudge){
     /* 1) Stop any ongoing motion & disable player detection */
     StopM();
+    Motor_ArmStall(0);
+    Jam_Reset();
+    turnDealt = 0;
+    stopMs = 0;
     Distance_Enable(0);
+    StopTracking();
+    FlushStore();
     HCSR04_Reset();
+    streaming = 0;
 
     /* 2) Stop motor timer if running */
     ES_Timer_StopTimer(TMR_MOTOR);
 
-    /* 3) Centre servo (MIN_PULSE_US) */
+    /* 3) Centre servo (MIN_PULSE_US); also cancels any profiled move */
     pulse = prevP = MIN_PULSE_US;
-    RC_SetPulseTime(SERVO_PIN, pulse);
+    sweepDir = 1;
+    ServoMotion_MoveTo(pulse, SM_STEP);
 
-    /* 4) Nudge cards (FastFwd for NUDGE_MS) */
-    FastFwd();
-    ES_Timer_InitTimer(TMR_MOTOR, NUDGE_MS);
+    /* 4) Nudge cards (forward for the nudge time) */
+    if(nudge){
+        Nudge();
+        ES_Timer_InitTimer(TMR_MOTOR, MotorTune_Get()->nudgeMs);
+    }
 
     /* 5) Keep a periodic heartbeat timer alive so we poll the slide-switch */
     ArmHeartbeat();
@@ -298,6 +916,116 @@ static void ResetIdle(void){
     KickWatchdog();
 }
 
+/* ResetIdle: GoIdle with the nudge, the usual way back to Idle */
+static void ResetIdle(void){
+    GoIdle(1);
+}
+
+/**
+ * SaveSeats:
+ *   - Writes the seats just calibrated, and the motor tuning, to flash for
+ *     the next warm start. 'stored' keeps the copy that is in flash.
+ */
+static void SaveSeats(void){
+    memset(&stored, 0, sizeof(stored));
+    stored.count = SeatTable_Count();
+    for(uint8_t i=0; i<stored.count; i++){
+        stored.angleUs[i] = SeatTable_Angle(i);
+        stored.widthUs[i] = SeatTable_Width(i);
+    }
+    stored.tune = *MotorTune_Get();
+    stored.baseValid = Baseline_Export(stored.baseCm);
+    printf(",,STORE=%u\r\n", SeatStore_Save(&stored));
+}
+
+/**
+ * SaveBaseline:
+ *   - Writes a newly recorded baseline to flash so it survives a power
+ *     cycle. Drops the stored seats: they were found against the old one.
+ */
+static void SaveBaseline(void){
+    stored.count = 0;
+    stored.tune = *MotorTune_Get();
+    stored.baseValid = Baseline_Export(stored.baseCm);
+    printf(",,STORE=%u\r\n", SeatStore_Save(&stored));
+}
+
+/**
+ * StartCalibration:
+ *   - Sends the servo to MIN_PULSE_US (the warm-up covers the travel) and
+ *     starts the calibration sweep, or the baseline scan if baseScan is set.
+ */
+static void StartCalibration(void){
+    pulse    = prevP = MIN_PULSE_US;
+    sweepDir = 1;
+    warmCnt  = WARMUP_STEPS;
+    ServoMotion_MoveTo(pulse, SM_STEP);
+    /* The baseline needs every bin, so it is always recorded in fine steps */
+    calStepUs = baseScan ? CAL_FINE_US : CAL_COARSE_US;
+    SeatTable_Clear();
+    streaming = STREAM_DEAL && !baseScan;
+    streamed  = 0;
+    roundStartMs = ES_Timer_GetTime();
+    if(baseScan){
+        Baseline_Begin();
+        puts(",,HSM=BASELINE");
+    } else {
+        SeatDetect_Begin();  /* the scan feeds the seat detector step by step */
+        puts(",,START=COLD");
+    }
+    ArmHeartbeat();
+    KickWatchdog();
+    State = CalSweepS;
+}
+
+/**
+ * StartVerify:
+ *   - Warm start: visits the stored seats in order; each one is pinged once
+ *     the servo has settled there.
+ */
+static void StartVerify(void){
+    ES_Timer_StopTimer(TMR_SWEEP);
+    idx = 0;
+    ServoMotion_MoveTo(stored.angleUs[0], SEEK_PROFILE);
+    KickWatchdog();
+    State = WarmVerifyS;
+    puts(",,HSM=VERIFY");
+}
+
+/**
+ * UseStoredSeats:
+ *   - Every stored seat answered the ping: deal to them without a sweep.
+ */
+static void UseStoredSeats(void){
+    SeatTable_Clear();
+    for(uint8_t i=0; i<stored.count && i < MAX_PLAYERS; i++){
+        uint8_t j = SeatTable_Add(stored.angleUs[i], stored.widthUs[i]);
+        printf(",,PLAYER%u=%u\r\n", j+1, stored.angleUs[i]);
+    }
+    puts(",,START=WARM");
+    printf(",,CAL_MS=%lu\r\n", (unsigned long)(ES_Timer_GetTime() - calStartMs));
+    StartDealing();
+}
+
+/**
+ * FinishCalibration:
+ *   - Takes the seats found, logs the calibration time, saves the seats and
+ *     starts dealing, or goes back to Idle if nobody was found.
+ */
+static void FinishCalibration(void){
+    TakeSeats();
+    printf(",,CAL_MS=%lu\r\n", (unsigned long)(ES_Timer_GetTime() - calStartMs));
+    if(SeatTable_Count()){
+        /* Save before the motor starts: the flash erase stalls the CPU */
+        SaveSeats();
+        /* Sort angles and deal every card */
+        StartDealing();
+    } else {
+        /* No players detected: bail back to Idle */
+        ResetIdle();
+    }
+}
+
 /* ????????? Framework glue ????????? */
 uint8_t PostCardDealerHSM(ES_Event e){
     return ES_PostToService(MyPrio, e);
@@ -307,11 +1035,36 @@ uint8_t InitCardDealerHSM(uint8_t p){
     MyPrio = p;
     /* Initialize game-select button service so we can receive GAME_BTN_PRESSED */
     GameButton_Init();
-    /* Add motor PWM pin to the PWM module and ensure motor is stopped */
-    PWM_AddPins(ENA_PWM_MACRO);
+    /* Motor pins are set up by FeedMotor_Init() in main(); make sure it's stopped */
     StopM();
-    /* Initialize servo to its minimum pulse */
+    FeedMotor_SetRamp(MOTOR_RAMP_MS, &MOTOR_RAMP_SHAPE);
+    BatComp_Enable(BAT_COMP);
+    if(CUR_TRIP_MA){
+        FeedMotor_SenseCurrent(CUR_TRIP_MA);
+    }
+    /* Roller encoder on IC1 (Timer3 is already running for the sonar) */
+    Encoder_Init();
+    /* Empty-table baseline and motor timing: as saved by this unit, else
+       none and the compile-time values */
+    if(!SeatStore_Load(&stored)){
+        memset(&stored, 0, sizeof(stored));
+    }
+    if(stored.baseValid){
+        Baseline_Import(stored.baseCm);
+    }
+    if(!MOTOR_TUNE || !stored.tune.fwdMs){
+        stored.tune.fwdMs   = MOTOR_FWD_MS;
+        stored.tune.lockMs  = MOTOR_LOCK_MS;
+        stored.tune.nudgeMs = NUDGE_MS;
+        stored.tune.duty    = DUTY_FAST;
+    }
+    MotorTune_Init(&stored.tune);
+    /* With the speed loop on, the duty only seeds it: don't tune it */
+    MotorTune_FixDuty(SPEED_CTL);
+    /* Initialize servo to its minimum pulse and hand it to the motion layer */
     RC_SetPulseTime(SERVO_PIN, MIN_PULSE_US);
+    ServoMotion_Init(SERVO_PIN);
+    ServoMotion_UseBatComp(BAT_COMP_SERVO);
     /* Configure LED pins as outputs */
     LED_D6_TRIS = LED_D7_TRIS = 0;
     /* Show initial game mode on LEDs */
@@ -338,17 +1091,28 @@ ES_Event RunCardDealerHSM(ES_Event ev){
         if(curSwitch == 0){
             /* OFF edge: immediately ResetIdle (regardless of current state) */
             ResetIdle();
+        } else if(State == IdleS && batCritical){
+            /* ON edge with the pack critical: stay Idle */
+            puts(",,BAT_REFUSE");
         } else if(State == IdleS){
-            /* ON edge, but only if we were Idle: begin calibration sweep */
-            players = idx = 0;
-            pulse   = prevP = MIN_PULSE_US;
-            warmCnt = WARMUP_STEPS;
-            memset(playerRemain, 0, sizeof(playerRemain));
+            /* ON edge, but only if we were Idle: warm start or calibration sweep */
+            SeatTable_Clear();
+            idx = 0;
             HCSR04_Reset();
-            Distance_Enable(1);  /* start sonar for player detection */
+            calStartMs = ES_Timer_GetTime();
+            firstCard  = 1;
+            AD_ClearStats();
+            ejectN = 0;
+            ejectSum = ejectSq = 0;
+            /* Button held at switch-on: this sweep records the empty table */
+            baseScan = GameButton_IsPressed();
             /* Log the starting game mode */
             printf(",,GAME=%s\r\n", ModeName(CurMode));
-            State = CalSweepS;
+            if(WARM_START && !baseScan && SeatStore_Load(&stored) && stored.count){
+                StartVerify();
+            } else {
+                StartCalibration();
+            }
         }
         prevSwitch = curSwitch;
     }
@@ -359,6 +1123,90 @@ ES_Event RunCardDealerHSM(ES_Event ev){
         return NO_EVENT;
     }
 
+    /* The Idle nudge has run its time. Idle, calibration and warm-start
+       verify run no motor of their own, so stop it (this also lets
+       BatteryService read the rest voltage again) */
+    if(ev.EventType == ES_TIMEOUT && ev.EventParam == TMR_MOTOR &&
+       (State == IdleS || State == CalSweepS || State == CalSeekS ||
+        State == CalRefineS || State == WarmVerifyS)){
+        StopM();
+        return NO_EVENT;
+    }
+
+    /* Battery grade changed: derate the motor when low. When critical, stop
+       the hand now if the motor is idle, else FireCard() stops it once the
+       card in hand is done */
+    if(ev.EventType == BAT_OK || ev.EventType == BAT_LOW || ev.EventType == BAT_CRITICAL){
+        batCritical = (ev.EventType == BAT_CRITICAL);
+        FeedMotor_SetDutyLimit(ev.EventType == BAT_OK ? MAX_PWM : BAT_LOW_DUTY);
+        if(batCritical && State != IdleS && State != DealRevS &&
+           State != DealLockS && State != JamBackS){
+            /* No nudge: the motor stays off on a critical pack */
+            puts(",,BAT_ABORT");
+            GoIdle(0);
+        }
+        return NO_EVENT;
+    }
+
+    /* Motor current tripped: FeedMotor has already cut the drive. A fling or
+       tuck recovers as from a stall below; anywhere else just stop */
+    if(ev.EventType == MOTOR_OVERCURRENT){
+        printf(",,OVERCURRENT=%u\r\n", ev.EventParam);
+        if(!(JAM_RECOVERY && (State == DealRevS || State == DealLockS))){
+            StopM();
+            return NO_EVENT;
+        }
+    }
+
+    /* Feed motor stalled (or tripped) mid-fling or mid-tuck: back the roller
+       off and retry the same phase; the seat table is untouched, so the deal
+       resumes */
+    if(JAM_RECOVERY && (ev.EventType == MOTOR_STALLED || ev.EventType == MOTOR_OVERCURRENT) &&
+       (State == DealRevS || State == DealLockS)){
+        uint16_t back = Jam_OnStall(ES_Timer_GetTime());
+        if(MOTOR_TUNE){
+            MotorTune_Stall();
+        }
+        ES_Timer_StopTimer(TMR_MOTOR);
+        Encoder_Disarm();
+        Motor_ArmStall(0);
+        StopM();
+        if(!back){
+            /* Retries used up: give up on the hand */
+            printf(",,JAM_FAIL=%u\r\n", idx+1);
+            ResetIdle();
+            return NO_EVENT;
+        }
+        printf(",,JAM=%u\r\n", Jam_Tries());
+        jamPhase = State;
+        if(State == DealRevS){
+            FastFwd();
+        } else {
+            FastRev();
+        }
+        ES_Timer_InitTimer(TMR_MOTOR, back);
+        KickWatchdog();
+        State = JamBackS;
+        return NO_EVENT;
+    }
+
+    /* Pipelined tuck: the servo got to the next seat before the tuck ended */
+    if(turnDealt && ev.EventType == SERVO_SETTLED && ev.EventParam == SeatTable_Angle(idx)){
+        pulse = prevP = ev.EventParam;
+        arrived = 1;
+        arriveMs = ES_Timer_GetTime();
+        arriveWaitMs = ServoMotion_LastWaitMs();
+        return NO_EVENT;
+    }
+
+    /* Seat tracking saw someone sit down where no seat was calibrated. They
+       join from the next hand, which has to calibrate to find their seat */
+    if(ev.EventType == SEAT_JOINED){
+        printf(",,NEW_SEAT=%u\r\n", ev.EventParam);
+        storeStale = 1;
+        return NO_EVENT;
+    }
+
     /* Game-select button allowed only in Idle: change game mode and log it */
     if(State == IdleS && ev.EventType == GAME_BTN_PRESSED){
         CurMode = (GameMode_t)ev.EventParam;
@@ -383,87 +1231,110 @@ ES_Event RunCardDealerHSM(ES_Event ev){
     /* ????? Calibration sweep ????? */
     case CalSweepS:
         if(ev.EventType == ES_TIMEOUT && ev.EventParam == TMR_SWEEP){
-            /* Perform one servo step; the function logs sonar telemetry */
-            uint8_t wrap = ServoStep();
             /* Restart heartbeat & watchdog */
             ArmHeartbeat();
             KickWatchdog();
-            /* If still warming up, decrement counter until zero, then print ,,READY */
-            if(warmCnt && --warmCnt == 0){
-                puts(",,READY");
+            /* If still warming up, hold still and count down, then print ,,READY */
+            if(warmCnt){
+                if(--warmCnt == 0){
+                    puts(",,READY");
+                }
+                break;
             }
-            /* Once warmed up: if we wrapped the sweep or reached max players, stop */
-            if(!warmCnt && (wrap || players == MAX_PLAYERS)){
-                /* Disable sonar distance events until after calibration */
-                Distance_Enable(0);
-                if(players){
-                    /* Sort found player angles in ascending order */
-                    SortAngles();
-                    /* Reset servo to MIN_PULSE_US to start dealing */
-                    pulse = prevP = MIN_PULSE_US;
-                    /* Each detected player already got one card in calibration,
-                       so subtract 1 from their remaining count */
-                    for(uint8_t i=0; i<players; i++){
-                        playerRemain[i] = CardsPP[CurMode] - 1;
-                    }
-                    idx = 0;                    /* start dealing with player 0 */
-                    State = DealSweepS;
-                    puts(",,HSM=SWEEP");
+            /* Perform one servo step; the function logs sonar telemetry */
+            uint8_t wrap = ServoStep(calStepUs);
+            if(!wrap){
+                /* Warmed up: hand this step's range to the baseline or the seat detector */
+                uint16_t cm = HCSR04_GetDistanceCm();
+                if(baseScan){
+                    Baseline_AddSample(pulse, cm);
                 } else {
-                    /* No players detected: bail back to Idle */
-                    ResetIdle();
+                    SeatDetect_AddSample(pulse, cm, IsSeatHit(cm));
+                    /* Streaming: go and deal to a seat as soon as it closes */
+                    if(StreamNext()){
+                        streamResumeUs = pulse;
+                        break;
+                    }
                 }
             }
-        }
-        /* On sonar detection (DIST_NEAR), record a player angle if conditions permit */
-        else if(ev.EventType == DIST_NEAR && warmCnt == 0 && players < MAX_PLAYERS){
-            uint16_t ang = pulse;
-            /* Only record if this is the first player or sufficiently far from last */
-            if(!players || (uint16_t)(ang - playerAngle[players-1]) > MIN_SEP_US){
-                playerAngle[players]  = ang;
-                playerRemain[players] = CardsPP[CurMode];
-                printf(",,PLAYER%u=%u\r\n", players+1, ang);
-                /* Pause sweep and schedule a calibration deal after MOTOR_DELAY_MS */
-                ES_Timer_StopTimer(TMR_SWEEP);
-                ES_Timer_InitTimer(TMR_MOTOR, MOTOR_DELAY_MS);
-                idx = players++;
-                State = CalDelayS;
+            /* The end of the arc ends the pass */
+            if(wrap && baseScan){
+                /* Baseline recorded: nothing to deal, wait for the next ON edge */
+                uint8_t bins = Baseline_End();
+                printf(",,BASE_BINS=%u\r\n", bins);
+                if(bins){
+                    SaveBaseline();
+                }
+                ResetIdle();
+            } else if(wrap && (calStepUs == CAL_FINE_US || streaming)){
+                /* Single fine pass, or a streaming pass: the seats are final */
+                FinishCalibration();
+            } else if(wrap){
+                /* Coarse pass done: re-sweep only around what it found */
+                SeatDetect_Finish();
+                calWins = SeatDetect_Windows(CAL_REFINE_US, MIN_PULSE_US,
+                                             MAX_PULSE_US, calWin);
+                SeatDetect_Begin();
+                calWinIdx = 0;
+                if(calWins){
+                    puts(",,HSM=REFINE");
+                    StartRefine();
+                } else {
+                    FinishCalibration();
+                }
             }
         }
         break;
 
-    case CalDelayS:
-        if(ev.EventType == ES_TIMEOUT && ev.EventParam == TMR_MOTOR){
-            /* Log calibration-deal pulse for console */
-            printf(",,CAL_DEAL_PULSE=%u\r\n", pulse);
-            /* Spin motor in ?deal? direction (reverse) for MOTOR_FWD_MS */
-            FastRev();
-            ES_Timer_InitTimer(TMR_MOTOR, MOTOR_FWD_MS);
-            State = CalRevS;
-            puts(",,HSM=FDEAL");
+    case CalSeekS:
+        /* At the start of the window: sweep it upward in fine steps */
+        if(ev.EventType == SERVO_SETTLED && ev.EventParam == calWin[calWinIdx].loUs){
+            pulse = prevP = ev.EventParam;
+            sweepDir = 1;
+            ES_Timer_InitTimer(TMR_SWEEP, CAL_FINE_MS);
+            KickWatchdog();
+            State = CalRefineS;
         }
         break;
 
-    case CalRevS:
-        if(ev.EventType == ES_TIMEOUT && ev.EventParam == TMR_MOTOR){
-            /* Stop reverse and immediately tuck forward to lock cards */
-            FastFwd();
-            ES_Timer_InitTimer(TMR_MOTOR, MOTOR_LOCK_MS);
-            State = CalLockS;
+    case WarmVerifyS:
+        if(ev.EventType == SERVO_SETTLED && ev.EventParam == stored.angleUs[idx]){
+            /* Arrived at a stored seat: give the sonar time for a fresh reading */
+            pulse = prevP = ev.EventParam;
+            ES_Timer_InitTimer(TMR_SWEEP, VERIFY_PING_MS);
+            KickWatchdog();
+        }
+        else if(ev.EventType == ES_TIMEOUT && ev.EventParam == TMR_SWEEP){
+            uint16_t cm = HCSR04_GetDistanceCm();
+            if(!IsSeatHit(cm)){
+                /* Nobody there any more: the stored seats are stale */
+                printf(",,VERIFY_FAIL=%u\r\n", idx+1);
+                StartCalibration();
+            } else if(++idx < stored.count){
+                ServoMotion_MoveTo(stored.angleUs[idx], SEEK_PROFILE);
+                KickWatchdog();
+            } else {
+                UseStoredSeats();
+            }
         }
         break;
 
-    case CalLockS:
-        if(ev.EventType == ES_TIMEOUT && ev.EventParam == TMR_MOTOR){
-            /* Stop motor, decrement that player's remaining count (one dealt) */
-            StopM();
-            --playerRemain[idx];
-            /* Restart sweep heartbeat & watchdog */
-            ArmHeartbeat();
+    case CalRefineS:
+        if(ev.EventType == ES_TIMEOUT && ev.EventParam == TMR_SWEEP){
+            ServoStep(CAL_FINE_US);
+            ES_Timer_InitTimer(TMR_SWEEP, CAL_FINE_MS);
             KickWatchdog();
-            /* Return to calibration sweep state */
-            State = CalSweepS;
-            puts(",,HSM=CAL");
+            uint16_t cm = HCSR04_GetDistanceCm();
+            SeatDetect_AddSample(pulse, cm, IsSeatHit(cm));
+            if(pulse >= calWin[calWinIdx].hiUs){
+                /* Close this window's region before moving to the next one */
+                SeatDetect_Finish();
+                if(++calWinIdx < calWins){
+                    StartRefine();
+                } else {
+                    FinishCalibration();
+                }
+            }
         }
         break;
 
@@ -472,18 +1343,10 @@ ES_Event RunCardDealerHSM(ES_Event ev){
             /* Completed the ?tuck? at end of calibration sweep */
             StopM();
             Distance_Enable(0);
-            if(players){
-                /* Prepare for dealing: sort angles, reset servo to MIN, set remain counts */
-                SortAngles();
-                pulse = prevP = MIN_PULSE_US;
-                for(uint8_t i=0; i<players; i++){
-                    playerRemain[i] = CardsPP[CurMode] - 1;
-                }
-                idx = 0;
-                State = DealSweepS;
-                ArmHeartbeat();
+            if(SeatTable_Count()){
+                /* Prepare for dealing: sort angles, set remain counts */
+                StartDealing();
                 KickWatchdog();
-                puts(",,HSM=SWEEP");
             } else {
                 /* No players found, return to Idle */
                 ResetIdle();
@@ -493,87 +1356,184 @@ ES_Event RunCardDealerHSM(ES_Event ev){
 
     /* ????? Dealing sweep ????? */
     case DealSweepS:
-        if(ev.EventType == ES_TIMEOUT && ev.EventParam == TMR_SWEEP){
+        if(DEAL_SEEK){
+            /* The profiled move to the current player has settled: deal now */
+            if(ev.EventType == SERVO_SETTLED && ev.EventParam == SeatTable_Angle(idx)){
+                pulse = prevP = ev.EventParam;
+                KickWatchdog();
+                ScheduleDeal(ServoMotion_LastWaitMs(), 0, DealDelayS);
+                puts(",,HSM=DELAY");
+            }
+        }
+        else if(ev.EventType == ES_TIMEOUT && ev.EventParam == TMR_SWEEP){
             /* Step the servo and log sonar telemetry */
-            uint8_t wrapped = ServoStep();
+            uint8_t wrapped = ServoStep(STEP_US);
             ArmHeartbeat();
             KickWatchdog();
-            /* If the sweep wrapped, do a small tuck before continuing (SweepNudgeS) */
-            if(wrapped){
+            /* If the sweep wrapped, do a small tuck before continuing (SweepNudgeS).
+               A ping-pong reversal has no jump, so it needs no tuck. */
+            if(wrapped && !SWEEP_PINGPONG){
                 ES_Timer_StopTimer(TMR_SWEEP);
-                FastFwd();
-                ES_Timer_InitTimer(TMR_MOTOR, NUDGE_MS);
+                Nudge();
+                ES_Timer_InitTimer(TMR_MOTOR, MotorTune_Get()->nudgeMs);
                 State = SweepNudgeS;
                 break;
             }
             /* If crossing a memorized player angle where cards remain, schedule a deal */
-            if(playerRemain[idx] && Cross(prevP, pulse, playerAngle[idx])){
+            if(SWEEP_PINGPONG ? CrossedOwed()
+                              : (SeatTable_Remain(idx) && Cross(prevP, pulse, SeatTable_Angle(idx)))){
                 ES_Timer_StopTimer(TMR_SWEEP);
-                ES_Timer_InitTimer(TMR_MOTOR, MOTOR_DELAY_MS);
-                State = DealDelayS;
+                ScheduleDeal(0, ServoMotion_SettleMs(STEP_US), DealDelayS);
                 puts(",,HSM=DELAY");
             }
         }
         break;
 
     case DealDelayS:
-        if(ev.EventType == ES_TIMEOUT && ev.EventParam == TMR_MOTOR){
+        if(ev.EventType == ES_TIMEOUT && ev.EventParam == TMR_MOTOR &&
+           SeatTrack_IsActive() && !SeatTrack_IsPresent(idx)){
+            /* The seat has emptied since calibration: drop the player's cards */
+            printf(",,P%u_SKIP=%u\r\n", idx+1, SeatTable_Remain(idx));
+            skipped += SeatTable_Remain(idx);
+            CountRound(SeatTable_Drop(idx));
+            NextDeal();
+        }
+        else if(ev.EventType == ES_TIMEOUT && ev.EventParam == TMR_MOTOR){
             /* Perform the actual deal for current player */
             printf(",,DEAL_PULSE=%u\r\n", pulse);
-            /* 1ms motor off for H-bridge discharge */
-            IO_PortsClearPortBits(PORTY, IN1_MASK | IN2_MASK);
-            _CP0_SET_COUNT(0);
-            while(_CP0_GET_COUNT() < (BOARD_GetPBClock() / 2 / 1000)){}
-            /* Spin motor in ?deal? direction (reverse) */
-            FastRev();
-            ES_Timer_InitTimer(TMR_MOTOR, MOTOR_FWD_MS);
-            State = DealRevS;
-            puts(",,HSM=DEAL");
+            if(firstCard){
+                /* Switch-on to first card, for warm vs cold start */
+                firstCard = 0;
+                printf(",,FIRST_CARD_MS=%lu\r\n",
+                       (unsigned long)(ES_Timer_GetTime() - calStartMs));
+            }
+            burstDealt = 0;
+            LogCycle();
+            FireCard();
         }
         break;
 
     case DealRevS:
-        if(ev.EventType == ES_TIMEOUT && ev.EventParam == TMR_MOTOR){
-            /* After reverse fling, perform forward tuck to lock */
-            FastFwd();
-            ES_Timer_InitTimer(TMR_MOTOR, MOTOR_LOCK_MS);
-            State = DealLockS;
+        if((ev.EventType == ES_TIMEOUT && ev.EventParam == TMR_MOTOR) ||
+           (ev.EventType == ENCODER_TARGET && ev.EventParam == EJECT_COUNTS)){
+            /* Card out (or the timeout hit): perform forward tuck to lock */
+            uint8_t byEncoder = (ev.EventType == ENCODER_TARGET);
+            ES_Timer_StopTimer(TMR_MOTOR);
+            LogEject(byEncoder);
+            StartTuck();
+            /* Only a card the encoder saw leave is safe to turn away from */
+            if(PIPELINE_TUCK && (byEncoder || !ENCODER_DEAL)){
+                MoveAhead();
+            }
         }
         break;
 
     case DealLockS:
-        if(ev.EventType == ES_TIMEOUT && ev.EventParam == TMR_MOTOR){
-            /* Stop motor, decrement that player's remaining count */
+        if((ev.EventType == ES_TIMEOUT && ev.EventParam == TMR_MOTOR) ||
+           (ev.EventType == ENCODER_TARGET && ev.EventParam == LOCK_COUNTS)){
+            /* Stop motor; another card of the burst if this seat is owed one */
+            ES_Timer_StopTimer(TMR_MOTOR);
+            Encoder_Disarm();
+            Motor_ArmStall(0);
             StopM();
-            --playerRemain[idx];
-            printf(",,P%u_LEFT=%u\r\n", idx+1, playerRemain[idx]);
-            /* If all cards dealt to all players, go to DonePauseS */
-            if(AllDealt()){
-                State = DonePauseS;
-                ArmHeartbeat();  /* keep polling switch after Done */
+            stopMs  = ES_Timer_GetTime();
+            stopCnt = Encoder_GetCount();
+            if(MOTOR_TUNE){
+                MotorTune_Lock((uint16_t)(ES_Timer_GetTime() - tuckStartMs),
+                               ev.EventType == ENCODER_TARGET);
+            }
+            uint32_t jamMs = Jam_OnDone(ES_Timer_GetTime());
+            if(jamMs){
+                /* Stall to recovered card */
+                printf(",,JAM_MS=%lu\r\n", (unsigned long)jamMs);
+            }
+            if(turnDealt){
+                /* Turn booked and servo sent on when the tuck started */
+                JoinAhead();
+                break;
+            }
+            burstDealt++;
+            uint8_t owed = streaming ? CardsPP[CurMode] : SeatTable_Remain(idx);
+            if(burstDealt < BurstCards[CurMode] && burstDealt < owed){
+                ES_Timer_InitTimer(TMR_MOTOR, BURST_GAP_MS);
                 KickWatchdog();
-                puts(",,HSM=DONE");
+                State = BurstGapS;
+                break;
+            }
+            if(streaming){
+                /* Round 0 from the sweep: the hand starts after calibration */
+                streamCards[idx] = burstDealt;
+                printf(",,P%u_LEFT=%u\r\n", idx+1, owed - burstDealt);
+                if(!StreamNext()){
+                    /* No other new seat: back to where the sweep stopped */
+                    ServoMotion_MoveTo(streamResumeUs, SEEK_PROFILE);
+                    KickWatchdog();
+                    State = StreamResumeS;
+                }
+                break;
+            }
+            /* Turn over: take the cards off that player's remaining count */
+            EndTurn();
+            /* Done if all cards are out, else on to the next player */
+            NextDeal();
+        }
+        break;
+
+    case BurstGapS:
+        if(ev.EventType == ES_TIMEOUT && ev.EventParam == TMR_MOTOR){
+            LogCycle();
+            FireCard();
+        }
+        break;
+
+    /* ????? Jam recovery ????? */
+    case JamBackS:
+        /* Back-off done: retry the fling or the tuck that stalled */
+        if(ev.EventType == ES_TIMEOUT && ev.EventParam == TMR_MOTOR){
+            StopM();
+            KickWatchdog();
+            if(jamPhase == DealRevS){
+                FireCard();
             } else {
-                /* Move to next player and resume dealing sweep */
-                AdvanceIdx();
-                State = DealSweepS;
-                ArmHeartbeat();
-                KickWatchdog();
-                puts(",,HSM=SWEEP");
+                StartTuck();
             }
         }
         break;
 
+    /* ????? Streaming deal (calibration sweep deals round 0) ????? */
+    case StreamSeekS:
+        /* At the seat the sweep just closed: deal its first card */
+        if(ev.EventType == SERVO_SETTLED && ev.EventParam == SeatTable_Angle(idx)){
+            pulse = prevP = ev.EventParam;
+            KickWatchdog();
+            ScheduleDeal(ServoMotion_LastWaitMs(), 0, DealDelayS);
+            puts(",,HSM=DELAY");
+        }
+        break;
+
+    case StreamResumeS:
+        /* Back where the sweep stopped: carry on scanning */
+        if(ev.EventType == SERVO_SETTLED && ev.EventParam == streamResumeUs){
+            pulse = prevP = streamResumeUs;
+            ArmHeartbeat();
+            KickWatchdog();
+            State = CalSweepS;
+            puts(",,HSM=CAL");
+        }
+        break;
+
     /* ????? Sweep-boundary tuck ????? */
     case SweepNudgeS:
         if(ev.EventType == ES_TIMEOUT && ev.EventParam == TMR_MOTOR){
             /* Finish the tuck, then either deal immediately if on a player angle,
                or resume the sweeping state. */
             StopM();
-            if(playerRemain[idx] &&
-               (pulse == playerAngle[idx] || Cross(prevP, pulse, playerAngle[idx]))){
-                ES_Timer_InitTimer(TMR_MOTOR, MOTOR_DELAY_MS);
-                State = DealDelayS;
+            if(SeatTable_Remain(idx) &&
+               (pulse == SeatTable_Angle(idx) || Cross(prevP, pulse, SeatTable_Angle(idx)))){
+                /* The wrap jumped the whole arc; the tuck already used the nudge time */
+                uint16_t nudge = MotorTune_Get()->nudgeMs;
+                uint16_t jump = ServoMotion_SettleMs(MAX_PULSE_US - MIN_PULSE_US);
+                ScheduleDeal(nudge, jump > nudge ? jump - nudge : 0, DealDelayS);
             } else {
                 State = DealSweepS;
                 ArmHeartbeat();
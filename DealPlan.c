@@ -0,0 +1,449 @@
+/* =============================================================================
+ * File:    DealPlan.c
+ * Purpose: Choose the order in which seats are visited during a hand so the
+ *          servo spends as little time moving as possible.
+ *
+ * Dependencies:
+ *   - none; the caller supplies the servo move-time model
+ *
+ * Behavior:
+ *   - Fairness: every seat gets one card per round, so a round visits each
+ *     seat exactly once. Seats lie on a line (the servo arc), so within a
+ *     round the shortest tour is a straight run from one end to the other;
+ *     the only choice is the direction of each round.
+ *   - Both directions cost the same between seats; they differ only in the
+ *     move onto the first seat. After an ascending round the servo sits on
+ *     the top seat, so a descending round starts with no move at all, while
+ *     another ascending round first has to cross the whole span.
+ *   - A two-state dynamic programme over the rounds (servo ends on the lowest
+ *     or on the highest seat) picks the cheapest directions, including the
+ *     first move from wherever the servo was left after calibration.
+ * =============================================================================
+ */
+#include <stdint.h>
+#include "DealPlan.h"
+
+/* ????????? Module State ????????? */
+static uint16_t dirMask;        /* bit r set: round r runs descending */
+static uint32_t planMs;
+static uint32_t rrMs;
+
+static uint16_t Dist(uint16_t a, uint16_t b) {
+    return (a > b) ? a - b : b - a;
+}
+
+uint32_t DealPlan_Build(const uint16_t *angleUs, uint8_t n, uint8_t cards,
+                        uint16_t startUs, DealPlan_MoveFn moveMs) {
+    dirMask = 0;
+    planMs = rrMs = 0;
+    if (n == 0 || cards == 0) {
+        return 0;
+    }
+    if (cards > PLAN_ROUNDS_MAX) {
+        cards = PLAN_ROUNDS_MAX;
+    }
+
+    uint16_t lo = angleUs[0], hi = angleUs[n - 1];
+    uint32_t inner = 0;         /* seat-to-seat moves of one round */
+    for (uint8_t i = 1; i < n; i++) {
+        inner += moveMs(angleUs[i] - angleUs[i - 1]);
+    }
+    uint32_t span = moveMs(hi - lo);
+    uint32_t stay = moveMs(0);
+
+    /* cost[e]: cheapest time so far ending on the low (0) or high (1) seat,
+       with the directions that got there in mask[e] */
+    uint32_t cost[2];
+    uint16_t mask[2];
+    cost[0] = moveMs(Dist(startUs, hi)) + inner;    /* descending */
+    mask[0] = 1;
+    cost[1] = moveMs(Dist(startUs, lo)) + inner;    /* ascending */
+    mask[1] = 0;
+
+    for (uint8_t r = 1; r < cards; r++) {
+        uint16_t bit = (uint16_t)(1u << r);
+        /* end low = run descending, entered from the high end */
+        uint32_t fromHi = cost[1] + stay, fromLo = cost[0] + span;
+        uint32_t endLo  = (fromHi <= fromLo) ? fromHi : fromLo;
+        uint16_t maskLo = ((fromHi <= fromLo) ? mask[1] : mask[0]) | bit;
+        /* end high = run ascending, entered from the low end */
+        fromLo = cost[0] + stay;
+        fromHi = cost[1] + span;
+        uint32_t endHi  = (fromLo <= fromHi) ? fromLo : fromHi;
+        uint16_t maskHi = (fromLo <= fromHi) ? mask[0] : mask[1];
+
+        cost[0] = endLo + inner;
+        mask[0] = maskLo;
+        cost[1] = endHi + inner;
+        mask[1] = maskHi;
+    }
+    uint8_t e = (cost[0] < cost[1]) ? 0 : 1;
+    dirMask = mask[e];
+    planMs  = cost[e];
+
+    /* Old order: ascending every round, jumping back down between rounds */
+    rrMs = moveMs(Dist(startUs, lo)) + inner + (uint32_t)(cards - 1) * (span + inner);
+    return planMs;
+}
+
+int8_t DealPlan_Dir(uint8_t round) {
+    if (round >= PLAN_ROUNDS_MAX) {
+        return 1;
+    }
+    return (dirMask & (1u << round)) ? -1 : 1;
+}
+
+uint32_t DealPlan_PlanMs(void) {
+    return planMs;
+}
+
+uint32_t DealPlan_RoundRobinMs(void) {
+    return rrMs;
+}
+
+/* ????????? Offline comparison ????????? */
+/*
+ * Build on a PC:  gcc -O2 -DDEAL_PLAN_TEST -o dealplan DealPlan.c -lm
+ * Run:            ./dealplan
+ *
+ * For every game in CardsPP and 2 to 10 seats spread evenly over the arc,
+ * prints the planned and round-robin deal time for a hand. The servo starts
+ * at the top of the arc, where a cold calibration leaves it. Servo time uses
+ * the SM_TRAPEZOID settle model from ServoMotion.c (constants copied below);
+ * each card adds SIM_CARD_MS of settle margin and motor time in both cases.
+ *
+ * Then, for burst dealing (k cards per stop, BURST_GAP_MS between them) at
+ * SIM_BURST_SEATS seats, prints the planned hand time and the expected
+ * double feeds per hand against one card per visit. The double-feed model is
+ * an assumption, not a measurement: a card fed from rest double-feeds with
+ * probability SIM_P_REST, and a card fired while the roller is still turning
+ * from the last tuck adds SIM_P_SPIN * exp(-gap / SIM_TAU_MS). Re-fit the
+ * three constants from bench counts before trusting the absolute rates.
+ *
+ * Last, switch-on to last card for a cold start, two-phase (coarse pass,
+ * refinement windows, then the planned hand) against streaming (one fine
+ * pass that stops at each seat as soon as it closes, SIM_STREAM_LAG_US past
+ * its centre, deals the first card and returns, then plans the rest). Sweep
+ * timing uses the CardDealerHSM.c calibration constants copied below.
+ *
+ * Then the pipelined tuck: per-card cycle (fire to fire) between adjacent
+ * seats with the servo move after the tuck (margin + fling + tuck + move)
+ * against overlapped with it (margin + fling + max(tuck, move)), and what
+ * that saves over a hand dealt in alternating directions, where every card
+ * but the first of each round follows a move to the adjacent seat.
+ *
+ * Last, the stepping sweep (DEAL_SEEK 0): time per dealing round with the
+ * sweep wrapping from MAX_PULSE_US to MIN_PULSE_US (plus the SweepNudgeS
+ * tuck) against ping-pong (SWEEP_PINGPONG), stepped tick by tick the way
+ * DealSweepS does it. Round times run from one round's last card to the
+ * next one's, as ,,ROUND_MS logs them. 'early' counts cards fired before the
+ * horn can have finished the wrap jump; the firmware only waits out one step.
+ *
+ * Finally, total deal time (,,DEAL_MS) for each game with 2 to 4 players:
+ * the wrapping stepping sweep against seeking straight to each seat in
+ * round-robin order (DEAL_PLAN 0) and in planned order.
+ */
+#ifdef DEAL_PLAN_TEST
+#include <stdio.h>
+#include <math.h>
+
+/* ServoMotion.c model constants */
+#define SERVO_US_PER_MS     4.0f
+#define SERVO_ACCEL_MS      40.0f
+#define RING_BASE_MS        30u
+#define RING_PER_100US_MS   6u
+#define PROFILE_US_PER_MS   3.2f
+#define PROFILE_ACCEL_MS    80.0f
+/* SETTLE_MARGIN_MS + MOTOR_FWD_MS + MOTOR_LOCK_MS in CardDealerHSM.c */
+#define SIM_CARD_MS         (20u + 350u + 175u)
+#define SIM_MIN_US          1000u
+#define SIM_MAX_US          2500u
+/* Burst comparison */
+#define SIM_BURST_SEATS     4
+#define SIM_VISIT_MS        20u             /* SETTLE_MARGIN_MS per stop */
+#define SIM_FIRE_MS         (350u + 175u)   /* MOTOR_FWD_MS + MOTOR_LOCK_MS */
+#define SIM_P_REST          0.005
+#define SIM_P_SPIN          0.25
+#define SIM_TAU_MS          40.0
+/* Calibration (CardDealerHSM.c / SeatDetect.c) */
+#define SIM_WARMUP_MS       (10u * 70u)     /* WARMUP_STEPS * STEP_MS */
+#define SIM_STEP_MS         70u
+#define SIM_COARSE_US       80u
+#define SIM_FINE_US         20u
+#define SIM_FINE_MS         40u
+#define SIM_REFINE_US       100u
+#define SIM_SEAT_US         200u            /* seat width, capped by spacing */
+#define SIM_GAP_US          100u            /* SEAT_GAP_US: closes a region */
+/* Pipelined tuck */
+#define SIM_MARGIN_MS       20u             /* SETTLE_MARGIN_MS */
+#define SIM_FLING_MS        350u            /* MOTOR_FWD_MS */
+#define SIM_TUCK_MS         175u            /* MOTOR_LOCK_MS */
+/* Stepping sweep */
+#define SIM_SWEEP_US        20u             /* STEP_US */
+#define SIM_NUDGE_MS        100u            /* NUDGE_MS */
+#define SIM_DELAY_MS        800u            /* MOTOR_DELAY_MS caps the settle wait */
+#define SIM_ROUNDS_MAX      7u
+
+static float Trap(float d, float v, float ta) {
+    float a = v / ta;
+    return (d <= v * ta) ? 2.0f * sqrtf(d / a) : d / v + ta;
+}
+
+static uint16_t SimMoveMs(uint16_t d) {
+    float p = Trap(d, PROFILE_US_PER_MS, PROFILE_ACCEL_MS);
+    float t = Trap(d, SERVO_US_PER_MS, SERVO_ACCEL_MS);
+    uint16_t ring = d ? RING_BASE_MS + (uint16_t)((uint32_t)d * RING_PER_100US_MS / 100u) : 0;
+    return (uint16_t)(((p > t) ? p : t) + 0.5f) + ring;
+}
+
+/* ServoMotion_SettleMs(): horn travel at its own limit plus ringing */
+static uint16_t SimSettleMs(uint16_t d) {
+    uint16_t ring = d ? RING_BASE_MS + (uint16_t)((uint32_t)d * RING_PER_100US_MS / 100u) : 0;
+    return (uint16_t)(Trap(d, SERVO_US_PER_MS, SERVO_ACCEL_MS) + 0.5f) + ring;
+}
+
+static uint32_t Steps(uint16_t span, uint16_t step) {
+    return (span + step - 1u) / step;
+}
+
+/* Cold start, calibrate then deal */
+static uint32_t TwoPhaseMs(const uint16_t *angle, uint8_t n, uint16_t w, uint8_t cards) {
+    uint32_t ms = SIM_WARMUP_MS + Steps(SIM_MAX_US - SIM_MIN_US, SIM_COARSE_US) * SIM_STEP_MS;
+    uint16_t at = SIM_MAX_US, lo = 0, hi = 0;
+    for (uint8_t i = 0; i <= n; i++) {
+        uint16_t l = (i < n) ? angle[i] - w / 2 - SIM_REFINE_US : 0;
+        if (i > 0 && (i == n || l > hi)) {
+            /* sweep the finished (merged) window */
+            ms += SimMoveMs(at > lo ? at - lo : lo - at) + Steps(hi - lo, SIM_FINE_US) * SIM_FINE_MS;
+            at = hi;
+        }
+        if (i == n) break;
+        if (i == 0 || l > hi) lo = l;
+        hi = angle[i] + w / 2 + SIM_REFINE_US;
+    }
+    DealPlan_Build(angle, n, cards, at, SimMoveMs);
+    return ms + DealPlan_PlanMs() + (uint32_t)n * cards * SIM_CARD_MS;
+}
+
+/* Cold start, first round dealt during a single sweep in 'step' us steps */
+static uint32_t StreamMs(const uint16_t *angle, uint8_t n, uint16_t w, uint8_t cards,
+                         uint16_t step) {
+    uint32_t ms = SIM_WARMUP_MS + Steps(SIM_MAX_US - SIM_MIN_US, step) * SIM_STEP_MS;
+    uint16_t lag = w / 2 + SIM_GAP_US + step / 2;
+    ms += (uint32_t)n * (2u * SimMoveMs(lag) + SIM_CARD_MS);
+    if (cards > 1) {
+        DealPlan_Build(angle, n, cards - 1, SIM_MAX_US, SimMoveMs);
+        ms += DealPlan_PlanMs() + (uint32_t)n * (cards - 1) * SIM_CARD_MS;
+    }
+    return ms;
+}
+
+/* Cross() in CardDealerHSM.c, both sweep shapes */
+static int SimCross(uint16_t a, uint16_t b, uint16_t t, uint8_t pingpong) {
+    if (pingpong) {
+        return (a < b && a < t && b >= t) || (a > b && b <= t && a > t);
+    }
+    return (a < b && a < t && b >= t) || (a > b && (a < t || b >= t));
+}
+
+/* One hand dealt by the stepping sweep, starting where StartDealing() leaves
+   the servo: on MIN_PULSE_US for wrap, at the top of the arc still heading up
+   for ping-pong. Fills roundMs[] and returns the hand time. */
+static uint32_t SweepHandMs(const uint16_t *angle, uint8_t n, uint8_t cards,
+                            uint8_t pingpong, uint32_t *roundMs, uint32_t *early) {
+    uint8_t  remain[10];
+    uint16_t pulse = pingpong ? SIM_MAX_US : SIM_MIN_US, prev = pulse;
+    int8_t   dir = 1;
+    uint8_t  idx = 0, left = n, round = 0, dealt = 0;
+    uint32_t t = 0, roundStart = 0, hornAt = 0;
+    uint16_t wait = SimSettleMs(SIM_SWEEP_US) + SIM_MARGIN_MS;
+    if (wait > SIM_DELAY_MS) {
+        wait = SIM_DELAY_MS;
+    }
+    for (uint8_t i = 0; i < n; i++) {
+        remain[i] = cards;
+    }
+    *early = 0;
+    while (dealt < (uint16_t)n * cards) {
+        t += SIM_STEP_MS;                       /* TMR_SWEEP */
+        prev = pulse;
+        if (pingpong) {
+            if ((dir > 0 && pulse >= SIM_MAX_US) || (dir < 0 && pulse <= SIM_MIN_US)) {
+                dir = -dir;
+            }
+            pulse = (dir > 0) ? pulse + SIM_SWEEP_US : pulse - SIM_SWEEP_US;
+        } else if (pulse >= SIM_MAX_US) {
+            /* wrap, then the tuck; no seat sits on MIN_PULSE_US here */
+            pulse = SIM_MIN_US;
+            hornAt = t + SimSettleMs(SIM_MAX_US - SIM_MIN_US);
+            t += SIM_NUDGE_MS;
+            continue;
+        } else {
+            pulse += SIM_SWEEP_US;
+        }
+        int8_t hit = -1;
+        if (pingpong) {
+            /* CrossedOwed(): lowest seat still owed a card this round */
+            uint8_t most = 0;
+            for (uint8_t i = 0; i < n; i++) {
+                if (remain[i] > most) most = remain[i];
+            }
+            for (uint8_t i = 0; i < n && hit < 0; i++) {
+                if (remain[i] == most && SimCross(prev, pulse, angle[i], 1)) hit = (int8_t)i;
+            }
+        } else if (remain[idx] && SimCross(prev, pulse, angle[idx], 0)) {
+            hit = (int8_t)idx;
+        }
+        if (hit < 0) {
+            continue;
+        }
+        t += wait;                              /* ScheduleDeal() */
+        if (t < hornAt) {
+            (*early)++;
+        }
+        t += SIM_FLING_MS + SIM_TUCK_MS;        /* DealRevS, DealLockS */
+        remain[hit]--;
+        dealt++;
+        if (--left == 0) {
+            roundMs[round++] = t - roundStart;
+            roundStart = t;
+            for (uint8_t i = 0; i < n; i++) {
+                left += (remain[i] != 0);
+            }
+        }
+        /* SeatTable_Next() */
+        for (uint8_t k = 1; k <= n; k++) {
+            uint8_t j = (uint8_t)((hit + k) % n);
+            if (remain[j]) {
+                idx = j;
+                break;
+            }
+        }
+    }
+    return t;
+}
+
+int main(void) {
+    static const uint8_t  cardsPP[] = {2, 5, 7};
+    static const char    *names[]   = {"Blackjack", "FiveCardDraw", "GoFish"};
+    uint16_t angle[10];
+
+    printf("game          seats  rr_ms   plan_ms  saved\r\n");
+    for (uint8_t g = 0; g < 3; g++) {
+        for (uint8_t n = 2; n <= 10; n++) {
+            for (uint8_t i = 0; i < n; i++) {
+                angle[i] = SIM_MIN_US + 100 + (uint16_t)((SIM_MAX_US - SIM_MIN_US - 200) * i / (n - 1));
+            }
+            DealPlan_Build(angle, n, cardsPP[g], SIM_MAX_US, SimMoveMs);
+            uint32_t motor = (uint32_t)n * cardsPP[g] * SIM_CARD_MS;
+            uint32_t rr = DealPlan_RoundRobinMs() + motor;
+            uint32_t pl = DealPlan_PlanMs() + motor;
+            printf("%-12s  %5u  %6lu  %7lu  %4.1f%%\r\n", names[g], n,
+                   (unsigned long)rr, (unsigned long)pl, 100.0 * (rr - pl) / rr);
+        }
+    }
+
+    static const uint16_t gaps[] = {0, 40, 80, 120, 160};
+    uint8_t n = SIM_BURST_SEATS;
+    for (uint8_t i = 0; i < n; i++) {
+        angle[i] = SIM_MIN_US + 100 + (uint16_t)((SIM_MAX_US - SIM_MIN_US - 200) * i / (n - 1));
+    }
+    printf("\r\n%u seats        k  gap_ms  hand_ms  vs_k1   double_feeds/hand\r\n", n);
+    for (uint8_t g = 0; g < 3; g++) {
+        uint32_t base = 0;
+        uint8_t  last = 0;
+        for (uint8_t k = 1; k <= cardsPP[g]; k++) {
+            uint8_t rounds = (cardsPP[g] + k - 1) / k;
+            if (rounds == last) continue;   /* same stops as a smaller k */
+            last = rounds;
+            /* cards fired straight after another one at the same stop */
+            uint32_t chained = (uint32_t)n * (cardsPP[g] - rounds);
+            uint32_t cards = (uint32_t)n * cardsPP[g];
+            for (uint8_t j = 0; j < sizeof gaps / sizeof gaps[0]; j++) {
+                if (k == 1 && j > 0) break;
+                DealPlan_Build(angle, n, rounds, SIM_MAX_US, SimMoveMs);
+                uint32_t ms = DealPlan_PlanMs() + (uint32_t)n * rounds * SIM_VISIT_MS
+                            + cards * SIM_FIRE_MS + chained * gaps[j];
+                double df = cards * SIM_P_REST
+                          + chained * SIM_P_SPIN * exp(-gaps[j] / SIM_TAU_MS);
+                if (k == 1) base = ms;
+                printf("%-12s  %3u  %6u  %7lu  %5.1f%%  %.3f\r\n", names[g], k,
+                       k == 1 ? 0 : gaps[j], (unsigned long)ms,
+                       100.0 * ((double)ms - base) / base, df);
+            }
+        }
+    }
+
+    printf("\r\ncold start    seats  two_phase_ms  stream_fine_ms  stream_coarse_ms  saved\r\n");
+    for (uint8_t g = 0; g < 3; g++) {
+        for (n = 2; n <= 6; n += 2) {
+            uint16_t span = (SIM_MAX_US - SIM_MIN_US - 200) / (n - 1);
+            uint16_t w = (span - SIM_GAP_US < SIM_SEAT_US) ? span - SIM_GAP_US : SIM_SEAT_US;
+            for (uint8_t i = 0; i < n; i++) {
+                angle[i] = SIM_MIN_US + 100 + span * i;
+            }
+            uint32_t two = TwoPhaseMs(angle, n, w, cardsPP[g]);
+            uint32_t fine = StreamMs(angle, n, w, cardsPP[g], SIM_FINE_US);
+            uint32_t coarse = StreamMs(angle, n, w, cardsPP[g], SIM_COARSE_US);
+            printf("%-12s  %5u  %12lu  %14lu  %16lu  %5.1f%%\r\n", names[g], n,
+                   (unsigned long)two, (unsigned long)fine, (unsigned long)coarse,
+                   100.0 * ((double)two - coarse) / two);
+        }
+    }
+
+    printf("\r\npipelined tuck\r\nseats  move_ms  serial_ms  overlap_ms  saved  hand_saved_ms %s/%s/%s\r\n",
+           names[0], names[1], names[2]);
+    for (n = 2; n <= 10; n++) {
+        uint16_t move = SimMoveMs((SIM_MAX_US - SIM_MIN_US - 200) / (n - 1));
+        uint16_t serial = SIM_MARGIN_MS + SIM_FLING_MS + SIM_TUCK_MS + move;
+        uint16_t overlap = SIM_MARGIN_MS + SIM_FLING_MS + (move > SIM_TUCK_MS ? move : SIM_TUCK_MS);
+        uint16_t per = serial - overlap;
+        printf("%5u  %7u  %9u  %10u  %4.1f%%  %lu/%lu/%lu\r\n", n, move, serial, overlap,
+               100.0 * per / serial, (unsigned long)cardsPP[0] * (n - 1) * per,
+               (unsigned long)cardsPP[1] * (n - 1) * per, (unsigned long)cardsPP[2] * (n - 1) * per);
+    }
+
+    printf("\r\nstepping sweep, round ms (first / mean of the rest)\r\n"
+           "game          seats  wrap_first  wrap_mean  early  "
+           "pp_first  pp_mean  wrap_hand  pp_hand  saved\r\n");
+    for (uint8_t g = 0; g < 3; g++) {
+        for (n = 2; n <= 6; n++) {
+            for (uint8_t i = 0; i < n; i++) {
+                angle[i] = SIM_MIN_US + 100 + (uint16_t)((SIM_MAX_US - SIM_MIN_US - 200) * i / (n - 1));
+            }
+            uint32_t rw[SIM_ROUNDS_MAX], rp[SIM_ROUNDS_MAX], early, none;
+            uint32_t hw = SweepHandMs(angle, n, cardsPP[g], 0, rw, &early);
+            uint32_t hp = SweepHandMs(angle, n, cardsPP[g], 1, rp, &none);
+            uint32_t sw = 0, sp = 0;
+            for (uint8_t r = 1; r < cardsPP[g]; r++) {
+                sw += rw[r];
+                sp += rp[r];
+            }
+            uint8_t rest = cardsPP[g] - 1;
+            printf("%-12s  %5u  %10lu  %9lu  %5lu  %8lu  %7lu  %9lu  %7lu  %4.1f%%\r\n",
+                   names[g], n, (unsigned long)rw[0], (unsigned long)(sw / rest),
+                   (unsigned long)early, (unsigned long)rp[0], (unsigned long)(sp / rest),
+                   (unsigned long)hw, (unsigned long)hp, 100.0 * ((double)hw - hp) / hw);
+        }
+    }
+
+    printf("\r\ndeal ms       seats  step_wrap  seek_rr  seek_plan  saved\r\n");
+    for (uint8_t g = 0; g < 3; g++) {
+        for (n = 2; n <= 4; n++) {
+            for (uint8_t i = 0; i < n; i++) {
+                angle[i] = SIM_MIN_US + 100 + (uint16_t)((SIM_MAX_US - SIM_MIN_US - 200) * i / (n - 1));
+            }
+            uint32_t rounds[SIM_ROUNDS_MAX], early;
+            uint32_t step = SweepHandMs(angle, n, cardsPP[g], 0, rounds, &early);
+            DealPlan_Build(angle, n, cardsPP[g], SIM_MAX_US, SimMoveMs);
+            uint32_t motor = (uint32_t)n * cardsPP[g] * SIM_CARD_MS;
+            uint32_t rr = DealPlan_RoundRobinMs() + motor;
+            uint32_t pl = DealPlan_PlanMs() + motor;
+            printf("%-12s  %5u  %9lu  %7lu  %9lu  %4.1f%%\r\n", names[g], n,
+                   (unsigned long)step, (unsigned long)rr, (unsigned long)pl,
+                   100.0 * ((double)step - rr) / step);
+        }
+    }
+    return 0;
+}
+#endif  /* DEAL_PLAN_TEST */
@@ -0,0 +1,38 @@
+/* DealPlan.h */
+
+#ifndef DEAL_PLAN_H
+#define DEAL_PLAN_H
+
+#include <stdint.h>
+
+/* Most rounds a plan covers (cards per player); later rounds go ascending */
+#define PLAN_ROUNDS_MAX  16
+
+/* Move-time model: ms from commanding a move of distUs until settled */
+typedef uint16_t (*DealPlan_MoveFn)(uint16_t distUs);
+
+/**
+ * @brief   Plan the direction of every round of a hand.
+ *          angleUs[] holds n seat centres in ascending order, each receiving
+ *          'cards' cards, one per round. The servo starts at startUs.
+ *          Each round visits the seats in angle order, up or down, and the
+ *          directions are chosen to minimise the total modelled move time.
+ * @return  Planned servo time for the hand (ms), as DealPlan_PlanMs().
+ */
+uint32_t DealPlan_Build(const uint16_t *angleUs, uint8_t n, uint8_t cards,
+                        uint16_t startUs, DealPlan_MoveFn moveMs);
+
+/**
+ * @brief   Direction of round r: +1 = ascending angle, -1 = descending.
+ */
+int8_t   DealPlan_Dir(uint8_t round);
+
+/**
+ * @brief   Modelled servo time of the planned hand, and of the same hand
+ *          dealt ascending every round (the old round robin), in ms.
+ *          Motor time per card is the same for both and is not included.
+ */
+uint32_t DealPlan_PlanMs(void);
+uint32_t DealPlan_RoundRobinMs(void);
+
+#endif  /* DEAL_PLAN_H */
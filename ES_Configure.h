@@ -25,23 +25,35 @@ typedef enum {
     DIST_FAR,         /* from SensorMotorEventChecker */
     MOTOR_STALLED,    /* from SensorMotorEventChecker */
     MOTOR_MOVING,     /* from SensorMotorEventChecker */
+    SEAT_JOINED,      /* from SensorMotorEventChecker (param = new seat pulse) */
 
     GAME_BTN_PRESSED, /* from GameButton */
 
+    SERVO_SETTLED,    /* from ServoMotion (param = target pulse) */
+    ENCODER_TARGET,   /* from Encoder (param = armed count) */
+    MOTOR_OVERCURRENT,/* from FeedMotor (param = mA at the trip) */
+
+    BAT_OK,           /* from BatteryService (param = rest mV) */
+    BAT_LOW,
+    BAT_CRITICAL,
+
+    AD_WINDOW,        /* from SensorMotorEventChecker (param = ADWIN_PARAM) */
+
     NUMBEROFEVENTS
 } ES_EventType_t;
 
 /* 2. Event-checker list */
 #define EVENT_CHECK_HEADER   "ProjectEventCheckers.h"
-#define EVENT_CHECK_LIST     CheckDistance, CheckMotor, CheckGameButton
+#define EVENT_CHECK_LIST     CheckDistance, CheckMotor, CheckGameButton, CheckServoMotion, \
+                             CheckSeatTrack, CheckEncoder, CheckFeedMotor, CheckADWindow
 
 /* 3. Timer-to-post mapping */
 #define TIMER_UNUSED         ((pPostFunc)0)
 #define TIMER0_RESP_FUNC     TIMER_UNUSED
 #define TIMER1_RESP_FUNC     PostCardDealerHSM  /* CardDealerHSM handles sweep & motor timers */
 #define TIMER2_RESP_FUNC     PostCardDealerHSM
-#define TIMER3_RESP_FUNC     TIMER_UNUSED
-#define TIMER4_RESP_FUNC     TIMER_UNUSED
+#define TIMER3_RESP_FUNC     PostCardDealerHSM  /* TMR_WDOG */
+#define TIMER4_RESP_FUNC     PostBatteryService /* TMR_BAT */
 #define TIMER5_RESP_FUNC     TIMER_UNUSED
 #define TIMER6_RESP_FUNC     TIMER_UNUSED
 #define TIMER7_RESP_FUNC     TIMER_UNUSED
@@ -56,7 +68,7 @@ typedef enum {
 
 /* 4. Services */
 #define MAX_NUM_SERVICES    4
-#define NUM_SERVICES        1
+#define NUM_SERVICES        2
 
 /* Service 0 is our CardDealerHSM */
 #define SERV_0_HEADER       "CardDealerHSM.h"
@@ -64,6 +76,12 @@ typedef enum {
 #define SERV_0_RUN          RunCardDealerHSM
 #define SERV_0_QUEUE_SIZE   8
 
+/* Service 1: battery monitor (grades the pack, posts BAT_x) */
+#define SERV_1_HEADER       "BatteryService.h"
+#define SERV_1_INIT         InitBatteryService
+#define SERV_1_RUN          RunBatteryService
+#define SERV_1_QUEUE_SIZE   8
+
 /* 5. Distribution lists ? not used here */
 #define NUM_DIST_LISTS      0
 
@@ -0,0 +1,133 @@
+/* =============================================================================
+ * File:    Encoder.c
+ * Purpose: Count feed-roller rotation so a deal can stop as soon as the card
+ *          is out, instead of after a fixed worst-case motor pulse.
+ *
+ * Dependencies:
+ *   - xc.h / attribs.h - IC1 registers and the __ISR() macro
+ *   - ES_Framework.h   - ES_PostAll() for ENCODER_TARGET
+ *   - SensorMotorEventChecker.h - Motor_EncoderPulse() for the stall checker
+ *
+ * Behavior:
+ *   - The encoder output is on RD8 (IC1). IC1 captures every rising edge on
+ *     Timer3, which HCSR04 already runs free at PBCLK/64.
+ *   - The ISR counts edges and timestamps them for the stall checker. Once
+ *     the armed count is reached it sets a flag; CheckEncoder() turns that
+ *     into one ENCODER_TARGET event.
+ *   - Speed: the ISR also keeps the Timer3 ticks between the last two edges.
+ *     Timer3 wraps every 105 ms, so an edge more than ENC_STALE_MS after the
+ *     one before starts the timing afresh, and Encoder_GetSpeed() reads 0
+ *     once no edge has come for ENC_STALE_MS.
+ * =============================================================================
+ */
+#include <xc.h>
+#include <sys/attribs.h>
+
+#include "BOARD.h"
+#include "ES_Configure.h"
+#include "ES_Framework.h"
+#include "ES_Timers.h"
+#include "SensorMotorEventChecker.h"
+#include "Encoder.h"
+
+/* ????????? Speed ????????? */
+/* Timer3 capture clock (prescale 1:64, set up by HCSR04_Init()) */
+#define ENC_TICK_HZ      (BOARD_GetPBClock() / 64u)
+/* No edge for this long (ms) = stopped; must stay under one Timer3 wrap */
+#define ENC_STALE_MS     80u
+
+/* ????????? Module State (volatile since used in ISR) ????????? */
+static volatile uint16_t count = 0;
+/* Armed count, 0 = not armed */
+static volatile uint16_t target = 0;
+/* 0 = waiting, 1 = target reached, 2 = event posted */
+static volatile uint8_t  reached = 0;
+/* Capture of the last edge, ticks since the edge before (0 = none yet),
+   ES_Timer time of the last edge, and a count of ISR runs so a reader can
+   tell it got all three from the same edge */
+static volatile uint16_t lastCap = 0;
+static volatile uint16_t period = 0;
+static volatile uint32_t lastMs = 0;
+static volatile uint8_t  seq = 0;
+
+void Encoder_Init(void) {
+    TRISDSET = _TRISD_TRISD8_MASK;      /* RD8 / IC1 input */
+    IC1CON = 0;
+    IC1CONbits.ICTMR = 0;               /* time base: Timer3 */
+    IC1CONbits.ICI   = 0;               /* interrupt on every capture */
+    IC1CONbits.ICM   = 0b011;           /* every rising edge */
+    IPC1bits.IC1IP   = 4;               /* same level as the sonar's IC4 */
+    IFS0CLR = _IFS0_IC1IF_MASK;
+    IEC0SET = _IEC0_IC1IE_MASK;
+    IC1CONbits.ON = 1;
+}
+
+void Encoder_Arm(uint16_t counts) {
+    target  = 0;                        /* ISR ignores the target while we reset */
+    count   = 0;
+    reached = 0;
+    target  = counts;
+}
+
+void Encoder_Disarm(void) {
+    target = 0;
+}
+
+uint16_t Encoder_GetCount(void) {
+    return count;
+}
+
+uint16_t Encoder_GetSpeed(void) {
+    uint16_t cap, per;
+    uint32_t ms;
+    uint8_t  s;
+    do {
+        s   = seq;
+        cap = lastCap;
+        per = period;
+        ms  = lastMs;
+    } while (s != seq);
+    if (per == 0 || ES_Timer_GetTime() - ms >= ENC_STALE_MS) {
+        return 0;
+    }
+    /* no edge yet for longer than the last period: slowing down */
+    uint16_t age = (uint16_t)(TMR3 - cap);
+    if (age > per) {
+        per = age;
+    }
+    return (uint16_t)(ENC_TICK_HZ / per);
+}
+
+uint8_t CheckEncoder(void) {
+    if (reached != 1) {
+        return 0;
+    }
+    reached = 2;
+    ES_Event e = { .EventType = ENCODER_TARGET, .EventParam = target };
+    ES_PostAll(e);
+    return 1;
+}
+
+/**
+ * IC1ISR
+ *   Drains the capture FIFO, one count per edge, times the edges and flags
+ *   the target.
+ */
+void __ISR(_INPUT_CAPTURE_1_VECTOR, IPL4SOFT) IC1ISR(void) {
+    uint32_t now = ES_Timer_GetTime();
+    uint8_t  fresh = (now - lastMs) < ENC_STALE_MS;
+    while (IC1CONbits.ICBNE) {
+        uint16_t cap = (uint16_t)IC1BUF;
+        period  = fresh ? (uint16_t)(cap - lastCap) : 0;
+        lastCap = cap;
+        fresh   = 1;
+        count++;
+    }
+    lastMs = now;
+    seq++;
+    IFS0CLR = _IFS0_IC1IF_MASK;
+    if (target && count >= target && reached == 0) {
+        reached = 1;
+    }
+    Motor_EncoderPulse();
+}
@@ -0,0 +1,44 @@
+/* Encoder.h */
+
+#ifndef ENCODER_H
+#define ENCODER_H
+
+#include <stdint.h>
+
+/**
+ * @brief   Set up Input Capture 1 (RD8) to count rising edges of the feed
+ *          roller encoder. Captures are timed on Timer3, so call after
+ *          HCSR04_Init(), which starts it.
+ */
+void     Encoder_Init(void);
+
+/**
+ * @brief   Start counting from zero; ENCODER_TARGET is posted once 'counts'
+ *          edges have been seen (EventParam = counts).
+ */
+void     Encoder_Arm(uint16_t counts);
+
+/**
+ * @brief   Stop watching for the target; edges are still counted.
+ */
+void     Encoder_Disarm(void);
+
+/**
+ * @brief   Edges counted since the last Encoder_Arm().
+ */
+uint16_t Encoder_GetCount(void);
+
+/**
+ * @brief   Roller speed in encoder counts per second, from the time between
+ *          the last two edges (or since the last edge, once that is longer).
+ *          0 when stopped. Safe to call from an interrupt below IPL4.
+ */
+uint16_t Encoder_GetSpeed(void);
+
+/**
+ * @brief   Event-checker: posts ENCODER_TARGET once per Encoder_Arm() when the
+ *          armed count is reached.
+ */
+uint8_t  CheckEncoder(void);
+
+#endif  /* ENCODER_H */
@@ -0,0 +1,314 @@
+/* =============================================================================
+ * File:    FeedMotor.c
+ * Purpose: One driver for the feed-roller H-bridge, shared by the dealer HSM
+ *          and the motor test, with braking and dead time on reversals.
+ *
+ * Dependencies:
+ *   - xc.h      - LATD / LATDINV / TRISDCLR for the IN pins
+ *   - pwm.h     - enable pin duty (PWM_PORTZ06, fast path), the ramp engine
+ *                 and the PWM period hook that times the speed loop
+ *   - SpeedCtl / Encoder - speed PID and the roller speed it regulates
+ *   - BatComp / AD   - battery feed-forward on the drive duty
+ *   - MotorCurrent / AD - shunt current trip and profile (A/D sample hook)
+ *   - ES_Timers - ES_Timer_GetTime() for the dead time
+ *   - ES_Framework.h - ES_PostAll() for MOTOR_OVERCURRENT
+ *
+ * Behavior:
+ *   - IN1 (PORTY-04) and IN2 (PORTY-05) are RD3 and RD5. Both change in one
+ *     write to LATDINV, so the bridge never passes through a half-set state,
+ *     and other LATD bits are left alone even if an ISR writes them.
+ *   - Order of writes: when starting to drive, pins first and then the duty;
+ *     when stopping, the duty (or brake pins) first.
+ *   - A change from one direction to the other coasts for FEED_DEAD_MS,
+ *     counted from when the old direction stopped being driven. The new
+ *     direction waits in 'pending' and CheckFeedMotor() applies it.
+ *   - With a soft start set, starting to drive (or reversing) writes duty 0
+ *     and hands the climb to the target to the pwm.c ramp engine. A new duty
+ *     in the same direction ramps from where the duty is.
+ *   - FeedMotor_Hold(): once the dead time and the soft start are over, the
+ *     PWM period hook steps SpeedCtl every SPEED_PERIOD_MS on the encoder
+ *     speed and writes the duty it returns. Every other call clears 'hold'
+ *     before it touches the pins or duty, so the interrupt never overwrites
+ *     them afterwards.
+ *   - Every drive duty (FWD/REV, and the speed loop's output) goes through
+ *     BatComp_Duty(); brake and coast don't. CheckFeedMotor() hands BatComp
+ *     the filtered battery voltage every FEED_BAT_MS, but only once the
+ *     motor has been off for FEED_BAT_REST_MS, so the reading is the
+ *     pack's rest voltage and not its sag under the motor. BatteryService
+ *     reads it under the same condition (FeedMotor_IsResting()).
+ *   - FeedMotor_SetDutyLimit() caps every drive duty after BatComp, the
+ *     speed loop's included, to derate the motor on a low battery.
+ *   - FeedMotor_SenseCurrent(): the bridge's sense resistor is read on
+ *     FEED_CUR_PIN and every reading goes to MotorCurrent from the A/D
+ *     interrupt. When the trip holds, the interrupt drops 'hold' and writes
+ *     duty 0 itself (cancelling any ramp), so the cut doesn't wait for the
+ *     main loop. The drive stays cut until the next coast or brake;
+ *     CheckFeedMotor() posts MOTOR_OVERCURRENT once per trip.
+ * =============================================================================
+ */
+#include <xc.h>
+#include <stdint.h>
+
+#include "BOARD.h"
+#include "pwm.h"
+#include "ES_Configure.h"
+#include "ES_Framework.h"
+#include "ES_Timers.h"
+#include "AD.h"
+#include "BatComp.h"
+#include "Encoder.h"
+#include "SpeedCtl.h"
+#include "MotorCurrent.h"
+#include "FeedMotor.h"
+
+/* ????????? Pins ????????? */
+#define FEED_PWM        PWM_PORTZ06         /* ENA */
+#define FEED_IN1        _LATD_LATD3_MASK    /* PORTY-04 */
+#define FEED_IN2        _LATD_LATD5_MASK    /* PORTY-05 */
+#define FEED_CUR_PIN    AD_PORTV3           /* L298N SENSE A, across the shunt */
+
+/* ????????? Tunables ????????? */
+/* Minimum coast between driving one direction and the other (ms). The
+   timer ticks in whole ms, so the real gap is FEED_DEAD_MS to +1 ms */
+#define FEED_DEAD_MS    1u
+/* Battery reading for BatComp: how often, and how long after the motor
+   last drove (ms) */
+#define FEED_BAT_MS     50u
+#define FEED_BAT_REST_MS 100u
+/* Sense resistor (milliohm); a full-scale 3.3 V reading is FEED_CUR_FULL_MA */
+#define FEED_SHUNT_MOHM 500u
+#define FEED_CUR_FULL_MA (3300000u / FEED_SHUNT_MOHM)
+#define FEED_AD_MAX     1023u
+
+/* ????????? Module State ????????? */
+static FeedMode_t mode = FEED_COAST;        /* on the pins now */
+static FeedMode_t asked = FEED_COAST;       /* last FeedMotor_Set() */
+/* Direction last driven and when it stopped being driven */
+static FeedMode_t lastDrive = FEED_COAST;
+static uint32_t   offMs = 0;
+/* Direction waiting for the dead time, and its duty */
+static volatile uint8_t pending = 0;
+static uint16_t   pendingDuty = 0;
+/* Soft start */
+static uint16_t   rampMs = 0;
+static const RampProfile_t *rampProfile = &Ramp_Linear;
+/* Fast-path handle of the enable pin */
+static PWM_Handle ena = PWM_NO_HANDLE;
+/* Speed hold: 1 while SpeedCtl owns the duty; PWM periods per control step */
+static volatile uint8_t hold = 0;
+static uint16_t   holdEvery = 1;
+static uint16_t   holdTick = 0;
+/* Last battery reading handed to BatComp */
+static uint32_t   batMs = 0;
+/* Current trip: set by the A/D interrupt, cleared by coast or brake */
+static uint8_t    senseOn = 0;
+static volatile uint8_t  tripped = 0;
+static volatile uint16_t tripMa = 0;
+static uint8_t    tripPosted = 0;
+/* Highest drive duty (derating) */
+static uint16_t   dutyMax = MAX_PWM;
+
+/* Sets IN1/IN2 to 'want' in one write */
+static inline void Pins(uint32_t want) {
+    LATDINV = (LATD ^ want) & (FEED_IN1 | FEED_IN2);
+}
+
+/* Drive duty after battery compensation and the derating cap */
+static inline uint16_t Scale(uint16_t duty) {
+    duty = BatComp_Duty(duty);
+    return (duty > dutyMax) ? dutyMax : duty;
+}
+
+/* Drive at 'duty', soft-starting from 0 if the direction is new */
+static void Drive(FeedMode_t m, uint32_t pins, uint16_t duty) {
+    duty = tripped ? 0 : Scale(duty);
+    /* out of a brake the enable is still at MAX_PWM: drop it before the
+       pins change, or the new direction starts at full, unscaled duty */
+    if (m != mode) {
+        PWM_SetDutyFast(ena, 0);
+    }
+    if (!rampMs) {
+        Pins(pins);
+        PWM_SetDutyFast(ena, duty);
+        if (tripped) {
+            PWM_SetDutyFast(ena, 0);
+        }
+        return;
+    }
+    Pins(pins);
+    PWM_Ramp(FEED_PWM, duty, rampMs, rampProfile);
+    /* a trip between the check above and here would be overwritten */
+    if (tripped) {
+        PWM_SetDutyFast(ena, 0);
+    }
+}
+
+/* PWM period hook (Timer2 interrupt): one SpeedCtl step every holdEvery */
+static void SpeedTick(void) {
+    if (!hold || tripped || ++holdTick < holdEvery) {
+        return;
+    }
+    holdTick = 0;
+    if (pending || !PWM_IsRampDone(FEED_PWM)) {
+        return;
+    }
+    PWM_SetDutyFast(ena, Scale(SpeedCtl_Step(Encoder_GetSpeed())));
+}
+
+/* A/D sample hook (ADC interrupt): every shunt reading, cut on a trip */
+static void CurrentSample(unsigned int counts) {
+    uint16_t ma = (uint16_t)((uint32_t)counts * FEED_CUR_FULL_MA / FEED_AD_MAX);
+    if (MotorCurrent_Sample(ma, ES_Timer_GetTime()) && !tripped) {
+        hold = 0;
+        PWM_SetDutyFast(ena, 0);
+        tripMa = ma;
+        tripped = 1;
+    }
+}
+
+static void Apply(FeedMode_t m, uint16_t duty) {
+    if ((mode == FEED_FWD || mode == FEED_REV) && m != mode) {
+        lastDrive = mode;
+        offMs = ES_Timer_GetTime();
+    }
+    if ((m == FEED_FWD || m == FEED_REV) && m != mode) {
+        MotorCurrent_Begin(ES_Timer_GetTime());
+    }
+    switch (m) {
+    case FEED_COAST:
+        PWM_SetDutyFast(ena, 0);
+        break;
+    case FEED_BRAKE:
+        Pins(FEED_IN1 | FEED_IN2);
+        PWM_SetDutyFast(ena, MAX_PWM);
+        break;
+    case FEED_FWD:
+        Drive(m, FEED_IN1, duty);
+        break;
+    case FEED_REV:
+        Drive(m, FEED_IN2, duty);
+        break;
+    }
+    if (m == FEED_COAST || m == FEED_BRAKE) {
+        MotorCurrent_End();
+    }
+    mode = m;
+}
+
+void FeedMotor_Init(void) {
+    TRISDCLR = FEED_IN1 | FEED_IN2;
+    LATDCLR  = FEED_IN1 | FEED_IN2;
+    PWM_AddPins(FEED_PWM);
+    ena = PWM_GetHandle(FEED_PWM);
+    PWM_SetDutyFast(ena, 0);
+    mode = asked = lastDrive = FEED_COAST;
+    pending = 0;
+    hold = 0;
+    SpeedCtl_Init();
+    holdEvery = (uint16_t)(PWM_GetFrequency() * SPEED_PERIOD_MS / 1000u);
+    if (holdEvery == 0) {
+        holdEvery = 1;
+    }
+}
+
+void FeedMotor_Set(FeedMode_t m, uint16_t duty) {
+    if (hold) {
+        hold = 0;
+        PWM_SetPeriodHook(NULL);
+    }
+    asked = m;
+    pending = 0;
+    if (m == FEED_FWD || m == FEED_REV) {
+        FeedMode_t other = (m == FEED_FWD) ? FEED_REV : FEED_FWD;
+        if (mode == other) {
+            Apply(FEED_COAST, 0);
+        }
+        if (mode != m && lastDrive == other &&
+            ES_Timer_GetTime() - offMs <= FEED_DEAD_MS) {
+            if (mode == FEED_BRAKE) {
+                Apply(FEED_COAST, 0);
+            }
+            pending = 1;
+            pendingDuty = duty;
+            return;
+        }
+    }
+    Apply(m, duty);
+    if (m == FEED_COAST || m == FEED_BRAKE) {
+        tripped = 0;
+        tripPosted = 0;
+    }
+}
+
+void FeedMotor_Coast(void) {
+    FeedMotor_Set(FEED_COAST, 0);
+}
+
+void FeedMotor_Brake(void) {
+    FeedMotor_Set(FEED_BRAKE, 0);
+}
+
+void FeedMotor_Fwd(uint16_t duty) {
+    FeedMotor_Set(FEED_FWD, duty);
+}
+
+void FeedMotor_Rev(uint16_t duty) {
+    FeedMotor_Set(FEED_REV, duty);
+}
+
+void FeedMotor_Hold(FeedMode_t m, SpeedPhase_t phase, uint16_t duty) {
+    FeedMotor_Set(m, duty);
+    if (m != FEED_FWD && m != FEED_REV) {
+        return;
+    }
+    SpeedCtl_Start(phase, duty);
+    holdTick = 0;
+    hold = 1;
+    PWM_SetPeriodHook(SpeedTick);
+}
+
+void FeedMotor_SenseCurrent(uint16_t ma) {
+    MotorCurrent_SetTrip(ma);
+    if (!senseOn && AD_AddPins(FEED_CUR_PIN) == SUCCESS) {
+        AD_SetSampleHook(FEED_CUR_PIN, CurrentSample);
+        senseOn = 1;
+    }
+}
+
+void FeedMotor_SetRamp(uint16_t ms, const RampProfile_t *profile) {
+    rampMs = ms;
+    rampProfile = profile;
+}
+
+void FeedMotor_SetDutyLimit(uint16_t duty) {
+    dutyMax = (duty > MAX_PWM) ? MAX_PWM : duty;
+}
+
+FeedMode_t FeedMotor_Mode(void) {
+    return asked;
+}
+
+uint8_t FeedMotor_IsResting(void) {
+    return (mode == FEED_COAST || mode == FEED_BRAKE) && !pending &&
+           ES_Timer_GetTime() - offMs >= FEED_BAT_REST_MS;
+}
+
+uint8_t CheckFeedMotor(void) {
+    uint32_t now = ES_Timer_GetTime();
+    if (FeedMotor_IsResting() && now - batMs >= FEED_BAT_MS) {
+        batMs = now;
+        BatComp_Update((uint16_t)AD_ReadBatteryMillivolts());
+    }
+    if (tripped && !tripPosted) {
+        tripPosted = 1;
+        ES_Event e = { .EventType = MOTOR_OVERCURRENT, .EventParam = tripMa };
+        ES_PostAll(e);
+        return 1;
+    }
+    if (pending && ES_Timer_GetTime() - offMs > FEED_DEAD_MS) {
+        /* direction first: the speed hook waits while pending is set */
+        Apply(asked, pendingDuty);
+        pending = 0;
+    }
+    return 0;
+}
@@ -0,0 +1,83 @@
+/* FeedMotor.h */
+
+#ifndef FEED_MOTOR_H
+#define FEED_MOTOR_H
+
+#include <stdint.h>
+#include "RampShape.h"
+#include "SpeedCtl.h"
+
+/* H-bridge modes of the feed-roller motor (L298N) */
+typedef enum {
+    FEED_COAST,     /* enable low: the roller spins down freely */
+    FEED_BRAKE,     /* enable high, IN1 = IN2 = 1: windings shorted, fast stop */
+    FEED_FWD,       /* IN1 = 1, IN2 = 0: tuck direction */
+    FEED_REV        /* IN1 = 0, IN2 = 1: deal (eject) direction */
+} FeedMode_t;
+
+/**
+ * @brief   Set up the IN1/IN2 outputs and the enable PWM pin and leave the
+ *          motor coasting. Call after PWM_Init().
+ */
+void       FeedMotor_Init(void);
+
+/**
+ * @brief   Switch to 'mode'; 'duty' (0..MAX_PWM) applies to FEED_FWD and
+ *          FEED_REV only. Reversing the direction first coasts for the dead
+ *          time; the new direction is then applied by CheckFeedMotor(), so
+ *          the call never blocks.
+ */
+void       FeedMotor_Set(FeedMode_t mode, uint16_t duty);
+
+void       FeedMotor_Coast(void);
+void       FeedMotor_Brake(void);
+void       FeedMotor_Fwd(uint16_t duty);
+void       FeedMotor_Rev(uint16_t duty);
+
+/**
+ * @brief   Drive FEED_FWD or FEED_REV at 'duty' (with the soft start, if
+ *          set), then hold phase's roller speed setpoint with SpeedCtl,
+ *          starting from 'duty'. Any other FeedMotor call ends the hold.
+ */
+void       FeedMotor_Hold(FeedMode_t mode, SpeedPhase_t phase, uint16_t duty);
+
+/**
+ * @brief   Start reading the motor current (A/D pin and sample hook) and
+ *          trip at 'ma': the drive is cut from the A/D interrupt, stays cut
+ *          until the next coast or brake, and MOTOR_OVERCURRENT (param = mA)
+ *          is posted. 0 mA = keep the current profile but never trip. Call
+ *          after AD_Init() and FeedMotor_Init().
+ */
+void       FeedMotor_SenseCurrent(uint16_t ma);
+
+/**
+ * @brief   Soft start: from now on FEED_FWD and FEED_REV ramp the duty up
+ *          from 0 over 'ms' along 'profile' (PWM_Ramp) whenever the motor
+ *          starts or changes direction. 0 ms = full duty at once.
+ */
+void       FeedMotor_SetRamp(uint16_t ms, const RampProfile_t *profile);
+
+/**
+ * @brief   Cap every drive duty at 'duty' (after battery compensation, the
+ *          speed loop's output included). MAX_PWM = no cap.
+ */
+void       FeedMotor_SetDutyLimit(uint16_t duty);
+
+/**
+ * @brief   Mode last asked for (it may still be waiting out the dead time).
+ */
+FeedMode_t FeedMotor_Mode(void);
+
+/**
+ * @brief   1 once the motor has been off (coast or brake) long enough for
+ *          the battery to read its rest voltage, else 0.
+ */
+uint8_t    FeedMotor_IsResting(void);
+
+/**
+ * @brief   Event-checker: applies a direction waiting on the dead time once
+ *          it has passed and posts MOTOR_OVERCURRENT after a current trip.
+ */
+uint8_t    CheckFeedMotor(void);
+
+#endif  /* FEED_MOTOR_H */
@@ -31,6 +31,7 @@
 #define DEBOUNCE_COUNT  6       /* samples needed to confirm state */
 
 static GameMode_t CurMode = GM_BLACKJACK;
+static uint8_t    stable  = 1;  /* last debounced reading (1 = released) */
 static const char *ModeName[GM_COUNT] = {
     "Blackjack",
     "FiveCardDraw",
@@ -64,6 +65,14 @@ GameMode_t Game_GetMode(void) {
     return CurMode;
 }
 
+/**
+ * GameButton_IsPressed()
+ *   Returns 1 while the debounced button is held down.
+ */
+uint8_t GameButton_IsPressed(void) {
+    return stable == BTN_ACTIVE_LO;
+}
+
 /**
  * CheckGameButton()
  *   Called by ES_CheckEvents each tick.
@@ -71,7 +80,6 @@ GameMode_t Game_GetMode(void) {
  */
 uint8_t CheckGameButton(void) {
     static uint32_t lastT   = 0;
-    static uint8_t  stable  = 1;    /* last stable reading */
     static uint8_t  count   = 0;    /* debounce counter */
 
     uint32_t now = ES_Timer_GetTime();
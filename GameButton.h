@@ -24,6 +24,11 @@ void        GameButton_Init(void);
  */
 GameMode_t  Game_GetMode(void);
 
+/**
+ * @brief   Returns 1 while the (debounced) button is held down.
+ */
+uint8_t     GameButton_IsPressed(void);
+
 /**
  * @brief   Event-checker for the game button.  
  *          Call in your event-checker list so that when the button is
@@ -18,6 +18,8 @@
 #define TRIG_PULSE_US   10
 /* How often (ms) to send a trigger pulse */
 #define PERIOD_MS       30
+/* Longest trigger period HCSR04_SetPeriodMs() accepts (keeps PR5 in 16 bits) */
+#define MAX_PERIOD_MS   200
 /* Microseconds required for sound to travel one centimeter and return */
 #define US_PER_CM       58
 
@@ -268,3 +270,33 @@ void HCSR04_Reset(void)
 
     __builtin_enable_interrupts();
 }
+
+/*****************************************************************************/
+/**
+ * HCSR04_SetPeriodMs()
+ *   ? Changes how often Timer5 fires a trigger pulse, from PERIOD_MS (full
+ *     rate) up to MAX_PERIOD_MS. A longer period saves ISR time and ping
+ *     traffic when readings are only needed now and then.
+ *   ? Lengthening takes effect at the end of the current period. When
+ *     shortening, a count already past the new PR5 would run on to 0xFFFF
+ *     and wrap (up to ~420 ms with no trigger), so the count is pulled in
+ *     to fire on the next tick instead.
+ */
+void HCSR04_SetPeriodMs(uint16_t ms)
+{
+    if(ms < PERIOD_MS) ms = PERIOD_MS;
+    else if(ms > MAX_PERIOD_MS) ms = MAX_PERIOD_MS;
+    /* Period = (PBCLK / prescale) * ms / 1000, prescale = 256 as in Init */
+    uint16_t period = (BOARD_GetPBClock() / 256) * ms / 1000;
+
+    /* Mask T5 so no trigger lands between the two writes */
+    uint32_t t5On = IEC0 & _IEC0_T5IE_MASK;
+    IEC0CLR = _IEC0_T5IE_MASK;
+    PR5 = period;
+    if(TMR5 >= period) {
+        TMR5 = period - 1;       /* past the new period: fire next tick */
+    }
+    if(t5On) {
+        IEC0SET = _IEC0_T5IE_MASK;
+    }
+}
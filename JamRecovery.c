@@ -0,0 +1,145 @@
+/* =============================================================================
+ * File:    JamRecovery.c
+ * Purpose: Retry policy for a feed motor that stalls on a jammed card.
+ *
+ * Dependencies:
+ *   - none; the caller reports stalls and drives the back-off
+ *
+ * Behavior:
+ *   - Each stall is answered with a back-off pulse in the opposite direction,
+ *     after which the caller retries the fling or tuck that stalled.
+ *   - The back-off grows with each try (JAM_BACK_MS, 2x, 3x...) so a light
+ *     snag costs little and a card wedged deeper gets more travel.
+ *   - After JAM_TRIES back-offs the next stall gives up, and the caller
+ *     escalates (the HSM goes back to Idle).
+ * =============================================================================
+ */
+#include <stdint.h>
+#include "JamRecovery.h"
+
+/* ????????? Tunables ????????? */
+#define JAM_TRIES        3u
+#define JAM_BACK_MS      80u
+
+/* ????????? Module State ????????? */
+static uint8_t  tries = 0;
+static uint8_t  jammed = 0;
+static uint32_t startMs = 0;
+
+uint16_t Jam_OnStall(uint32_t nowMs) {
+    if (!jammed) {
+        jammed  = 1;
+        startMs = nowMs;
+    }
+    if (tries >= JAM_TRIES) {
+        Jam_Reset();
+        return 0;
+    }
+    tries++;
+    return (uint16_t)(JAM_BACK_MS * tries);
+}
+
+uint32_t Jam_OnDone(uint32_t nowMs) {
+    uint32_t down = jammed ? nowMs - startMs : 0;
+    Jam_Reset();
+    return down;
+}
+
+void Jam_Reset(void) {
+    tries = jammed = 0;
+}
+
+uint8_t Jam_Tries(void) {
+    return tries;
+}
+
+/* ????????? Offline simulation ????????? */
+/*
+ * Build on a PC:  gcc -O2 -DJAM_TEST -o jam JamRecovery.c -lm
+ * Run:            ./jam [jams]
+ *
+ * Each simulated jam stalls the fling at a random point of MOTOR_FWD_MS.
+ * It clears on the first back-off at least SIM_NEED_MS long, where
+ * SIM_NEED_MS is drawn from an exponential with mean SIM_NEED_MEAN_MS;
+ * SIM_HARD of jams never clear. These are assumptions, not measurements.
+ * A stall is seen STALL_TIMEOUT_MS after the last encoder edge, or
+ * STALL_TIMEOUT_MS + STALL_GRACE_MS into a retry that never turns.
+ * Downtime runs from the stall to the start of the retry that works.
+ *
+ * Compared against escalating straight to Idle, as the watchdog path does:
+ * the rest of WDOG_MS since the fire, then a cold calibration (SIM_CAL_MS)
+ * before the hand can be dealt again from the start.
+ */
+#ifdef JAM_TEST
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+/* CardDealerHSM.c / SensorMotorEventChecker.c constants */
+#define MOTOR_FWD_MS      350u
+#define WDOG_MS           3000u
+#define STALL_TIMEOUT_MS  60u
+#define STALL_GRACE_MS    80u
+#define DEAD_MS           1u
+/* Jam model */
+#define SIM_NEED_MEAN_MS  100.0
+#define SIM_HARD          0.05
+#define SIM_CAL_MS        3700u     /* coarse + refinement estimate */
+
+static double Uniform(void) {
+    return (rand() + 1.0) / (RAND_MAX + 2.0);
+}
+
+static int CmpU32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+int main(int argc, char **argv) {
+    int jams = (argc > 1) ? atoi(argv[1]) : 10000;
+    uint32_t *down = malloc(sizeof(uint32_t) * jams);
+    double sumNew = 0.0, sumOld = 0.0, sumTries = 0.0;
+    int recovered = 0;
+    srand(1);
+
+    for (int j = 0; j < jams; j++) {
+        uint32_t tStall = (uint32_t)(Uniform() * MOTOR_FWD_MS);
+        double   need = -SIM_NEED_MEAN_MS * log(Uniform());
+        int      hard = Uniform() < SIM_HARD;
+
+        /* stall detected STALL_TIMEOUT_MS after the roller stopped */
+        uint32_t now = STALL_TIMEOUT_MS;
+        uint16_t back;
+        Jam_Reset();
+        while ((back = Jam_OnStall(now)) != 0) {
+            now += DEAD_MS + back;
+            if (!hard && back >= need) {
+                break;
+            }
+            /* retry never turns: stalls again after grace + timeout */
+            now += DEAD_MS + STALL_GRACE_MS + STALL_TIMEOUT_MS;
+        }
+        uint32_t old = (WDOG_MS - tStall) + SIM_CAL_MS;
+        if (back) {
+            sumTries += Jam_Tries();
+            down[j] = Jam_OnDone(now) + STALL_TIMEOUT_MS;
+            recovered++;
+        } else {
+            /* gave up: escalate to Idle like the old path, but at once */
+            down[j] = now + SIM_CAL_MS;
+        }
+        sumNew += down[j];
+        sumOld += old;
+    }
+    qsort(down, jams, sizeof(uint32_t), CmpU32);
+
+    printf("jams=%d  recovered=%.1f%%  mean tries=%.2f\r\n", jams,
+           100.0 * recovered / jams, recovered ? sumTries / recovered : 0.0);
+    printf("downtime per jam, recovery: mean=%.0f ms  p50=%u  p95=%u  max=%u\r\n",
+           sumNew / jams, down[jams / 2], down[jams * 95 / 100], down[jams - 1]);
+    printf("downtime per jam, to Idle:  mean=%.0f ms (plus the hand redealt)\r\n",
+           sumOld / jams);
+    free(down);
+    return 0;
+}
+#endif  /* JAM_TEST */
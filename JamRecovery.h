@@ -0,0 +1,34 @@
+/* JamRecovery.h */
+
+#ifndef JAM_RECOVERY_H
+#define JAM_RECOVERY_H
+
+#include <stdint.h>
+
+/**
+ * @brief   The feed motor stalled at nowMs. The first stall of a card starts
+ *          the downtime clock.
+ * @return  Length (ms) of the back-off pulse to run in the opposite
+ *          direction before retrying, or 0 once the retries are used up
+ *          (the jam is then forgotten and the caller gives up).
+ */
+uint16_t Jam_OnStall(uint32_t nowMs);
+
+/**
+ * @brief   The card's motor sequence finished at nowMs; clears the retries.
+ * @return  Downtime (ms) from the first stall to now if the card jammed,
+ *          else 0.
+ */
+uint32_t Jam_OnDone(uint32_t nowMs);
+
+/**
+ * @brief   Forget any jam in progress (the hand was abandoned).
+ */
+void     Jam_Reset(void);
+
+/**
+ * @brief   Back-off pulses run so far for the current card.
+ */
+uint8_t  Jam_Tries(void);
+
+#endif  /* JAM_RECOVERY_H */
@@ -0,0 +1,290 @@
+/* =============================================================================
+ * File:    MotorCurrent.c
+ * Purpose: Feed-motor current from the sense shunt: an overcurrent trip that
+ *          acts within a few A/D samples, and a current profile of each run.
+ *
+ * Dependencies:
+ *   - none; FeedMotor.c feeds it from the A/D sample hook
+ *   - test build: RampShape.c and BatComp.c (with BatMonitor.h) - the drive
+ *     ramp and battery compensation of the simulated fling
+ *
+ * Behavior:
+ *   - FeedMotor.c calls MotorCurrent_Sample() from the A/D interrupt with
+ *     every shunt reading, and cuts the motor itself while it returns 1.
+ *   - The trip needs CUR_TRIP_SAMPLES readings in a row at or over the trip
+ *     level, so one noisy conversion can't stop a deal.
+ *   - Each run (Begin to End) keeps the peak, the mean and the mean in each
+ *     CUR_BIN_MS bin from the start; later samples only count toward the
+ *     peak and mean.
+ * =============================================================================
+ */
+#include <stdint.h>
+#include "MotorCurrent.h"
+
+/* ????????? Tunables ????????? */
+#define CUR_TRIP_SAMPLES 2u
+
+/* ????????? Module State ????????? */
+static volatile uint8_t armed = 0;
+static uint16_t tripMa = 0;
+static uint8_t  over = 0;
+static uint32_t startMs = 0;
+static uint32_t binSum[CUR_BINS];
+static uint16_t binN[CUR_BINS];
+static uint32_t total = 0;
+static uint32_t count = 0;
+static uint16_t peak = 0;
+static MotorCurrentProfile_t prof;
+
+void MotorCurrent_SetTrip(uint16_t ma) {
+    tripMa = ma;
+}
+
+uint16_t MotorCurrent_Trip(void) {
+    return tripMa;
+}
+
+void MotorCurrent_Begin(uint32_t nowMs) {
+    armed = 0;
+    for (uint8_t b = 0; b < CUR_BINS; b++) {
+        binSum[b] = 0;
+        binN[b] = 0;
+    }
+    total = count = 0;
+    peak = 0;
+    over = 0;
+    startMs = nowMs;
+    armed = 1;
+}
+
+void MotorCurrent_End(void) {
+    armed = 0;
+}
+
+uint8_t MotorCurrent_Sample(uint16_t ma, uint32_t nowMs) {
+    if (!armed) {
+        return 0;
+    }
+    uint32_t b = (nowMs - startMs) / CUR_BIN_MS;
+    if (b < CUR_BINS) {
+        binSum[b] += ma;
+        binN[b]++;
+    }
+    total += ma;
+    count++;
+    if (ma > peak) {
+        peak = ma;
+    }
+    if (tripMa && ma >= tripMa) {
+        if (over < CUR_TRIP_SAMPLES) {
+            over++;
+        }
+    } else {
+        over = 0;
+    }
+    return over >= CUR_TRIP_SAMPLES;
+}
+
+const MotorCurrentProfile_t *MotorCurrent_Profile(void) {
+    prof.peakMa = peak;
+    prof.meanMa = count ? (uint16_t)(total / count) : 0;
+    prof.bins = 0;
+    for (uint8_t b = 0; b < CUR_BINS; b++) {
+        prof.binMa[b] = binN[b] ? (uint16_t)(binSum[b] / binN[b]) : 0;
+        if (binN[b]) {
+            prof.bins = b + 1;
+        }
+    }
+    return &prof;
+}
+
+/* ????????? Offline simulation ????????? */
+/*
+ * Build on a PC:  gcc -O2 -DMOTOR_CURRENT_TEST -o motorcurrent MotorCurrent.c RampShape.c BatComp.c -lm
+ * Run:            ./motorcurrent
+ *
+ * Motor and battery model of RampShape.c's simulation (same constants,
+ * 40 ms Ramp_Exp soft start), pack at rest SIM_V_LO..SIM_V_HI with the
+ * BatComp duty scaling, card drag SIM_LOAD +- SIM_LOAD_VAR. The shunt
+ * (SIM_SHUNT ohm) reading goes through an RC filter of SIM_SENSE_TAU and is
+ * converted every SIM_AD_S (battery + shunt scanned) to 10 bits of 3.3 V.
+ *   - Normal flings: how often the trip fires with no jam (false trips),
+ *     and the highest reading seen.
+ *   - Jams: at a random time SIM_JAM_LO..SIM_JAM_HI ms into the fling the
+ *     roller is blocked (SIM_JAM_NM extra drag). The motor is cut either by
+ *     the trip at the A/D sample that completes it, or by CheckMotor's
+ *     encoder timeout (STALL_TIMEOUT_MS after the last edge, plus
+ *     STALL_GRACE_MS if none was seen yet), polled every SIM_POLL_MS.
+ * Prints, for each method, the mean / 95th percentile / worst time from jam
+ * to motor cut, the mean energy put into the winding (i^2 R) meanwhile, and
+ * the mean time from the motor current reaching the trip level to the cut.
+ * Every constant is an assumption, not a measurement.
+ */
+#ifdef MOTOR_CURRENT_TEST
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "RampShape.h"
+#include "BatComp.h"
+
+#define SIM_FLINGS       4000
+#define SIM_DT           1e-5
+#define SIM_PWM_S        1e-3
+#define SIM_V_LO         8.6
+#define SIM_V_HI         10.8
+#define SIM_RBAT         0.35
+#define SIM_R            3.0
+#define SIM_K            0.30
+#define SIM_J            8e-4
+#define SIM_B            2e-3
+#define SIM_LOAD         0.15
+#define SIM_LOAD_VAR     0.25
+#define SIM_RADIUS       0.012
+#define SIM_EXIT_MM      60.0
+#define SIM_RAMP_MS      40u
+#define SIM_CPR          (24.0 / (SIM_EXIT_MM / 1000.0 / SIM_RADIUS))
+#define SIM_SHUNT        0.5
+#define SIM_SENSE_TAU    0.5e-3
+#define SIM_AD_S         (2.0 / 9345.0)
+#define SIM_TRIP_MA      2200u
+#define SIM_JAM_LO       60.0
+#define SIM_JAM_HI       200.0
+#define SIM_JAM_NM       2.0
+#define SIM_POLL_MS      1u
+#define SIM_STALL_MS     60u        /* STALL_TIMEOUT_MS */
+#define SIM_GRACE_MS     80u        /* STALL_GRACE_MS */
+
+typedef struct {
+    uint8_t  tripped;
+    double   cutMs;         /* jam to cut (jams only) */
+    double   joules;        /* winding energy from jam to cut */
+    double   overMs;        /* motor current over the trip level to cut */
+    uint16_t peakMa;
+} Run_t;
+
+static double Uniform(double lo, double hi) {
+    return lo + (hi - lo) * rand() / (double)RAND_MAX;
+}
+
+/* byCurrent: 1 = the trip cuts the motor, 0 = the encoder timeout does.
+   jamMs < 0 = no jam, run until the card is out */
+static Run_t Fling(uint8_t byCurrent, double cell, double load, double jamMs) {
+    Run_t r = {0, 0, 0, 0, 0};
+    double w = 0, theta = 0, t = 0, duty = 0, sense = 0, overAt = -1;
+    double nextTick = 0, nextAd = 0, nextEdge = 1.0 / SIM_CPR;
+    double exitRad = SIM_EXIT_MM / 1000.0 / SIM_RADIUS;
+    uint32_t tick = 0, lastEdgeMs = 0, nextPollMs = 0;
+    uint8_t edgeSeen = 0, cut = 0;
+    uint16_t target;
+
+    BatComp_Update((uint16_t)(cell * 1000.0));
+    target = BatComp_Duty(1000);
+    MotorCurrent_Begin(0);
+    while (t < 1.0) {
+        uint32_t ms = (uint32_t)(t * 1000.0);
+        uint8_t jammed = (jamMs >= 0 && t * 1000.0 >= jamMs);
+        if (jamMs < 0 && theta >= exitRad) {
+            break;
+        }
+        if (!cut && t >= nextTick) {
+            duty = Ramp_At(&Ramp_Exp, 0, target, tick, SIM_RAMP_MS) / 1000.0;
+            tick++;
+            nextTick += SIM_PWM_S;
+        }
+        double i = (duty * cell - SIM_K * w) / (SIM_R + duty * SIM_RBAT);
+        if (i < 0) i = 0;
+        double drag = load + (jammed ? SIM_JAM_NM : 0);
+        double torque = SIM_K * i - SIM_B * w - (w > 0 || SIM_K * i > drag ? drag : SIM_K * i);
+        w += torque / SIM_J * SIM_DT;
+        if (w < 0) w = 0;
+        theta += w * SIM_DT;
+        sense += (i - sense) * SIM_DT / SIM_SENSE_TAU;
+        if (jammed && !cut) {
+            r.joules += i * i * SIM_R * SIM_DT;
+            if (overAt < 0 && i * 1000.0 >= SIM_TRIP_MA) {
+                overAt = t;
+            }
+        }
+        if (theta >= nextEdge) {
+            lastEdgeMs = ms;
+            edgeSeen = 1;
+            nextEdge += 1.0 / SIM_CPR;
+        }
+        if (t >= nextAd) {
+            uint16_t counts = (uint16_t)fmin(1023.0, sense * SIM_SHUNT / 3.3 * 1023.0 + 0.5);
+            uint16_t ma = (uint16_t)(counts * (uint32_t)(3300.0 / SIM_SHUNT) / 1023u);
+            if (ma > r.peakMa) r.peakMa = ma;
+            if (MotorCurrent_Sample(ma, ms) && !r.tripped) {
+                r.tripped = 1;
+                if (byCurrent && !cut) {
+                    cut = 1;
+                    duty = 0;
+                    r.cutMs = t * 1000.0 - jamMs;
+                    r.overMs = (overAt < 0) ? 0 : (t - overAt) * 1000.0;
+                }
+            }
+            nextAd += SIM_AD_S;
+        }
+        if (!byCurrent && !cut && ms >= nextPollMs) {
+            uint32_t limit = SIM_STALL_MS + (edgeSeen ? 0 : SIM_GRACE_MS);
+            if (ms - lastEdgeMs > limit) {
+                cut = 1;
+                duty = 0;
+                r.cutMs = t * 1000.0 - jamMs;
+                r.overMs = (overAt < 0) ? 0 : (t - overAt) * 1000.0;
+            }
+            nextPollMs += SIM_POLL_MS;
+        }
+        if (cut && jammed) {
+            break;
+        }
+        t += SIM_DT;
+    }
+    return r;
+}
+
+static int Cmp(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static void Jams(const char *name, uint8_t byCurrent) {
+    static double lat[SIM_FLINGS];
+    double sum = 0, joules = 0, over = 0;
+    srand(2);
+    for (int k = 0; k < SIM_FLINGS; k++) {
+        double cell = Uniform(SIM_V_LO, SIM_V_HI);
+        double load = SIM_LOAD * Uniform(1.0 - SIM_LOAD_VAR, 1.0 + SIM_LOAD_VAR);
+        Run_t r = Fling(byCurrent, cell, load, Uniform(SIM_JAM_LO, SIM_JAM_HI));
+        lat[k] = r.cutMs;
+        sum += r.cutMs;
+        joules += r.joules;
+        over += r.overMs;
+    }
+    qsort(lat, SIM_FLINGS, sizeof lat[0], Cmp);
+    printf("%-16s %8.2f  %8.2f  %8.2f  %9.3f  %8.2f\r\n", name, sum / SIM_FLINGS,
+           lat[SIM_FLINGS * 95 / 100], lat[SIM_FLINGS - 1], joules / SIM_FLINGS,
+           over / SIM_FLINGS);
+}
+
+int main(void) {
+    int falseTrips = 0;
+    uint16_t peak = 0;
+    BatComp_Enable(1);
+    MotorCurrent_SetTrip(SIM_TRIP_MA);
+    srand(1);
+    for (int k = 0; k < SIM_FLINGS; k++) {
+        double cell = Uniform(SIM_V_LO, SIM_V_HI);
+        double load = SIM_LOAD * Uniform(1.0 - SIM_LOAD_VAR, 1.0 + SIM_LOAD_VAR);
+        Run_t r = Fling(1, cell, load, -1);
+        falseTrips += r.tripped;
+        if (r.peakMa > peak) peak = r.peakMa;
+    }
+    printf("trip %u mA: normal flings %d, false trips %d, highest reading %u mA\r\n",
+           SIM_TRIP_MA, SIM_FLINGS, falseTrips, peak);
+    printf("jam cut by       mean_ms   p95_ms    worst_ms  winding_J  over_ms\r\n");
+    Jams("current trip", 1);
+    Jams("encoder timeout", 0);
+    return 0;
+}
+#endif  /* MOTOR_CURRENT_TEST */
@@ -0,0 +1,48 @@
+/* MotorCurrent.h */
+
+#ifndef MOTOR_CURRENT_H
+#define MOTOR_CURRENT_H
+
+#include <stdint.h>
+
+/* Current profile of one motor run: CUR_BIN_MS wide bins from its start */
+#define CUR_BIN_MS   25u
+#define CUR_BINS     16u
+
+typedef struct {
+    uint16_t peakMa;
+    uint16_t meanMa;
+    uint8_t  bins;              /* bins with samples in them */
+    uint16_t binMa[CUR_BINS];   /* mean current in each bin */
+} MotorCurrentProfile_t;
+
+/**
+ * @brief   Trip level in mA; 0 = never trip (the profile is still kept).
+ */
+void     MotorCurrent_SetTrip(uint16_t ma);
+uint16_t MotorCurrent_Trip(void);
+
+/**
+ * @brief   The motor has started a run: clear the profile and arm the trip.
+ */
+void     MotorCurrent_Begin(uint32_t nowMs);
+
+/**
+ * @brief   The motor has stopped: samples are ignored until the next Begin.
+ */
+void     MotorCurrent_End(void);
+
+/**
+ * @brief   One current sample (from the A/D interrupt). Adds it to the
+ *          profile and returns 1 while the trip condition holds (at or over
+ *          the trip level for CUR_TRIP_SAMPLES samples in a row), else 0.
+ */
+uint8_t  MotorCurrent_Sample(uint16_t ma, uint32_t nowMs);
+
+/**
+ * @brief   Profile of the current (or last) run. Reading it while the run
+ *          goes on can mix a sample or two from before and after a read.
+ */
+const MotorCurrentProfile_t *MotorCurrent_Profile(void);
+
+#endif  /* MOTOR_CURRENT_H */
@@ -7,13 +7,9 @@
 #include "HCSR04.h"
 
 #include "pwm.h"
+#include "FeedMotor.h"      // L298N pins and modes
 #include "ES_Framework.h"   // for ES_PostAll & event defs
 
-/* ---- L298N wiring masks ------------------------------------------- */
-#define ENA_PWM_MACRO  PWM_PORTZ06   // RD0 / PORTZ-06  (PWM)
-#define IN1_MASK       PIN4          // PORTY-04
-#define IN2_MASK       PIN5          // PORTY-05
-
 /* ---- Distance-to-motor config ------------------------------------- */
 #define THRESH_NEAR_CM  25
 #define THRESH_FAR_CM   50
@@ -24,26 +20,11 @@
 #define DUTY_FAST   1000
 
 /* ------------------------------------------------------------------- */
-static inline void Motor_SetDuty(uint16_t duty) {
-    PWM_SetDutyCycle(ENA_PWM_MACRO, duty);
-}
-static inline void Motor_SetDirection(uint8_t dir) {
-    if (dir) {
-        /* reverse */
-        IO_PortsClearPortBits(PORTY, IN1_MASK);
-        IO_PortsSetPortBits  (PORTY, IN2_MASK);
-    } else {
-        /* forward */
-        IO_PortsSetPortBits  (PORTY, IN1_MASK);
-        IO_PortsClearPortBits(PORTY, IN2_MASK);
-    }
-}
-
-static inline void Motor_Stop(void)    { Motor_SetDuty(DUTY_STOP); }
-static inline void Motor_SlowFwd(void) { Motor_SetDirection(0); Motor_SetDuty(DUTY_SLOW); }
-static inline void Motor_FastFwd(void) { Motor_SetDirection(0); Motor_SetDuty(DUTY_FAST); }
-static inline void Motor_SlowRev(void) { Motor_SetDirection(1); Motor_SetDuty(DUTY_SLOW); }
-static inline void Motor_FastRev(void) { Motor_SetDirection(1); Motor_SetDuty(DUTY_FAST); }
+static inline void Motor_Stop(void)    { FeedMotor_Coast(); }
+static inline void Motor_SlowFwd(void) { FeedMotor_Fwd(DUTY_SLOW); }
+static inline void Motor_FastFwd(void) { FeedMotor_Fwd(DUTY_FAST); }
+static inline void Motor_SlowRev(void) { FeedMotor_Rev(DUTY_SLOW); }
+static inline void Motor_FastRev(void) { FeedMotor_Rev(DUTY_FAST); }
 
 /* ------------------------------------------------------------------- */
 
@@ -53,17 +34,12 @@ int main(void)
     BOARD_Init();
     HCSR04_Init();
 
-    /* Motor IO-setup */
-    IO_PortsSetPortOutputs(PORTY, IN1_MASK | IN2_MASK);
-    IO_PortsClearPortBits (PORTY, IN1_MASK | IN2_MASK);
-
     if (PWM_Init() == ERROR) {
         printf("PWM_Init failed\r\n");
         while (1);
     }
     PWM_SetFrequency(PWM_1KHZ);
-    PWM_AddPins(ENA_PWM_MACRO);
-    Motor_Stop();
+    FeedMotor_Init();
 
     printf("Boot OK ? distance?motor **debug mode**\r\n");
     printf("CSV: dist_cm,duty,event\r\n");
@@ -71,6 +47,7 @@ int main(void)
     uint16_t lastDuty = DUTY_STOP;
 
     while (1) {
+        CheckFeedMotor();   /* no ES_Run() here: apply reversals ourselves */
         if (HCSR04_NewReadingAvailable()) {
             uint16_t d   = HCSR04_GetDistanceCm();
             ES_Event  evt = INIT_EVENT;
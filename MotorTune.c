@@ -0,0 +1,247 @@
+/* =============================================================================
+ * File:    MotorTune.c
+ * Purpose: Fit the feed-motor timing of this unit from how its deals go, so
+ *          pulses don't have to be padded for the worst roller and battery.
+ *
+ * Dependencies:
+ *   - none
+ *
+ * Behavior:
+ *   - Fling and tuck times measured by the encoder go into running averages
+ *     of the mean and the mean absolute deviation (1/8 weight per card).
+ *   - Once TUNE_WARMUP cards have been seen, each pulse length becomes
+ *     mean + TUNE_DEV_K deviations + TUNE_MARGIN_MS, so the time tracks the
+ *     unit instead of the worst case. The nudge keeps its ratio to the tuck.
+ *   - A fling or tuck that runs out before the encoder target means the
+ *     pulse was too short: it grows by TUNE_STEP_MS at once. A stall raises
+ *     the duty by TUNE_DUTY_STEP.
+ *   - The duty holds the mean fling inside [TUNE_FAST_MS, TUNE_SLOW_MS]:
+ *     a fresh battery and roller throw cards no harder than needed, a
+ *     sagging one gets more drive back. MotorTune_FixDuty(1) turns this and
+ *     the stall step off, for when SpeedCtl sets the roller speed itself:
+ *     the fling time then follows the setpoint, not the duty.
+ *   - Every value stays inside the TUNE_*_MIN / TUNE_*_MAX bounds.
+ * =============================================================================
+ */
+#include <stdint.h>
+#include "MotorTune.h"
+
+/* ????????? Tunables ????????? */
+#define TUNE_WARMUP      8u
+#define TUNE_DEV_K       4u
+#define TUNE_MARGIN_MS   30u
+#define TUNE_STEP_MS     20u
+#define TUNE_FAST_MS     150u
+#define TUNE_SLOW_MS     250u
+#define TUNE_DUTY_STEP   25u
+/* Nudge as a fraction of the tuck (NUDGE_MS / MOTOR_LOCK_MS) */
+#define TUNE_NUDGE_NUM   100u
+#define TUNE_NUDGE_DEN   175u
+/* A value has to move by 1/TUNE_SAVE_FRAC of itself to be saved */
+#define TUNE_SAVE_FRAC   10u
+
+/* Safe bounds */
+#define TUNE_FWD_MIN     120u
+#define TUNE_FWD_MAX     500u
+#define TUNE_LOCK_MIN    60u
+#define TUNE_LOCK_MAX    300u
+#define TUNE_NUDGE_MIN   40u
+#define TUNE_NUDGE_MAX   150u
+#define TUNE_DUTY_MIN    600u
+#define TUNE_DUTY_MAX    1000u      /* MAX_PWM */
+
+/* Running mean and mean absolute deviation, both x16 */
+typedef struct {
+    uint16_t n;
+    int32_t  mean16;
+    int32_t  dev16;
+} Stat_t;
+
+/* ????????? Module State ????????? */
+static MotorTune_t tune;
+static Stat_t      eject, lock;
+static uint8_t     dutyFixed = 0;
+
+static uint16_t Clamp(uint32_t v, uint16_t lo, uint16_t hi) {
+    return (v < lo) ? lo : (v > hi) ? hi : (uint16_t)v;
+}
+
+static void StatAdd(Stat_t *s, uint16_t ms) {
+    int32_t x16 = (int32_t)ms << 4;
+    if (s->n == 0) {
+        s->mean16 = x16;
+        s->dev16  = 0;
+    } else {
+        int32_t err = x16 - s->mean16;
+        s->mean16 += err / 8;
+        s->dev16  += ((err < 0 ? -err : err) - s->dev16) / 8;
+    }
+    if (s->n < 0xFFFF) {
+        s->n++;
+    }
+}
+
+/* Pulse length that covers the spread seen so far */
+static uint32_t Cover(const Stat_t *s) {
+    return (uint32_t)((s->mean16 + TUNE_DEV_K * s->dev16) >> 4) + TUNE_MARGIN_MS;
+}
+
+static void ClampAll(void) {
+    tune.fwdMs   = Clamp(tune.fwdMs,   TUNE_FWD_MIN,   TUNE_FWD_MAX);
+    tune.lockMs  = Clamp(tune.lockMs,  TUNE_LOCK_MIN,  TUNE_LOCK_MAX);
+    tune.nudgeMs = Clamp((uint32_t)tune.lockMs * TUNE_NUDGE_NUM / TUNE_NUDGE_DEN,
+                         TUNE_NUDGE_MIN, TUNE_NUDGE_MAX);
+    tune.duty    = Clamp(tune.duty,    TUNE_DUTY_MIN,  TUNE_DUTY_MAX);
+}
+
+void MotorTune_Init(const MotorTune_t *start) {
+    tune = *start;
+    ClampAll();
+    eject.n = lock.n = 0;
+}
+
+const MotorTune_t *MotorTune_Get(void) {
+    return &tune;
+}
+
+void MotorTune_FixDuty(uint8_t fixed) {
+    dutyFixed = fixed;
+}
+
+void MotorTune_Eject(uint16_t ms, uint8_t reached) {
+    if (!reached) {
+        tune.fwdMs += TUNE_STEP_MS;
+        ClampAll();
+        return;
+    }
+    StatAdd(&eject, ms);
+    if (eject.n < TUNE_WARMUP) {
+        return;
+    }
+    tune.fwdMs = Cover(&eject);
+    /* Duty: keep the mean fling inside the band */
+    uint16_t mean = (uint16_t)(eject.mean16 >> 4);
+    if (dutyFixed) {
+        /* speed-regulated: nothing to adjust */
+    } else if (mean < TUNE_FAST_MS && tune.duty > TUNE_DUTY_MIN) {
+        tune.duty -= TUNE_DUTY_STEP;
+    } else if (mean > TUNE_SLOW_MS) {
+        tune.duty += TUNE_DUTY_STEP;
+    }
+    ClampAll();
+}
+
+void MotorTune_Lock(uint16_t ms, uint8_t reached) {
+    if (!reached) {
+        tune.lockMs += TUNE_STEP_MS;
+        ClampAll();
+        return;
+    }
+    StatAdd(&lock, ms);
+    if (lock.n >= TUNE_WARMUP) {
+        tune.lockMs = Cover(&lock);
+        ClampAll();
+    }
+}
+
+void MotorTune_Stall(void) {
+    if (!dutyFixed) {
+        tune.duty += TUNE_DUTY_STEP;
+        ClampAll();
+    }
+}
+
+static uint8_t Moved(uint16_t now, uint16_t was) {
+    uint16_t d = (now > was) ? now - was : was - now;
+    return d * TUNE_SAVE_FRAC >= was;
+}
+
+uint8_t MotorTune_NeedsSave(const MotorTune_t *saved) {
+    return Moved(tune.fwdMs, saved->fwdMs) || Moved(tune.lockMs, saved->lockMs) ||
+           Moved(tune.duty, saved->duty);
+}
+
+/* ????????? Offline simulation ????????? */
+/*
+ * Build on a PC:  gcc -O2 -DMOTOR_TUNE_TEST -o motortune MotorTune.c -lm
+ * Run:            ./motortune
+ *
+ * Simulates SIM_CARDS deals on one unit, starting from the compile-time
+ * defaults (350 / 175 / 100 ms, duty 1000), once for a typical roller and
+ * once for a strong new one that wears out. The true fling time at full duty
+ * wears linearly over the run, battery sag adds up
+ * to SIM_SAG over each SIM_CHARGE cards, it scales with 1/duty, and each card
+ * adds Gaussian noise of SIM_SIGMA_MS. The tuck takes SIM_LOCK_RATIO of
+ * the fling. These are assumptions, not bench data.
+ * Per block of SIM_BLOCK cards the harness prints the mean true fling time,
+ * the tuned fling and tuck lengths and duty, the share of flings the tuned
+ * length would have cut short, and the open-loop motor time per card tuned
+ * against fixed, then the card the tuning first took effect and how many
+ * flings the fixed 350 ms would have cut short.
+ */
+#ifdef MOTOR_TUNE_TEST
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#define SIM_CARDS       4000
+#define SIM_BLOCK       500
+#define SIM_SAG         0.15
+#define SIM_CHARGE      1000
+#define SIM_SIGMA_MS    12.0
+#define SIM_LOCK_RATIO  0.45
+#define FIXED_FWD_MS    350u
+#define FIXED_LOCK_MS   175u
+
+static double Gauss(void) {
+    double u = (rand() + 1.0) / (RAND_MAX + 2.0), v = (rand() + 1.0) / (RAND_MAX + 2.0);
+    return sqrt(-2.0 * log(u)) * cos(6.283185307 * v);
+}
+
+/* One unit whose fling at full duty wears from wear0 to wear1 ms */
+static void Run(double wear0, double wear1) {
+    MotorTune_t start = {FIXED_FWD_MS, FIXED_LOCK_MS, 100u, 1000u};
+    double sumT = 0, sumF = 0, sumL = 0, sumD = 0, sumTuned = 0;
+    int cut = 0, cutFixed = 0, warm = -1;
+    MotorTune_Init(&start);
+    srand(1);
+
+    printf("wear %.0f -> %.0f ms\r\n", wear0, wear1);
+    printf("cards      true_ms  fwd_ms  lock_ms  duty  cut_short  motor_ms tuned/fixed\r\n");
+    for (int c = 0; c < SIM_CARDS; c++) {
+        const MotorTune_t *t = MotorTune_Get();
+        double wear = wear0 + (wear1 - wear0) * c / SIM_CARDS;
+        double sag  = 1.0 + SIM_SAG * (c % SIM_CHARGE) / SIM_CHARGE;
+        double T = wear * sag * (1000.0 / t->duty) + SIM_SIGMA_MS * Gauss();
+        double L = SIM_LOCK_RATIO * T + 0.5 * SIM_SIGMA_MS * Gauss();
+        uint16_t fwd = t->fwdMs, lk = t->lockMs;
+
+        if (warm < 0 && fwd != FIXED_FWD_MS) warm = c;
+        sumT += T; sumF += fwd; sumL += lk; sumD += t->duty;
+        sumTuned += fwd + lk;
+        cut += T > fwd;
+        cutFixed += T > FIXED_FWD_MS;
+
+        /* encoder closed loop: the card ends at T unless the timeout hits */
+        if (T < fwd) MotorTune_Eject((uint16_t)T, 1); else MotorTune_Eject(fwd, 0);
+        if (L < lk)  MotorTune_Lock((uint16_t)L, 1);  else MotorTune_Lock(lk, 0);
+
+        if ((c + 1) % SIM_BLOCK == 0) {
+            printf("%4d-%-4d  %7.0f  %6.0f  %7.0f  %4.0f  %8.1f%%  %5.0f / %u\r\n",
+                   c + 2 - SIM_BLOCK, c + 1, sumT / SIM_BLOCK, sumF / SIM_BLOCK,
+                   sumL / SIM_BLOCK, sumD / SIM_BLOCK, 100.0 * cut / SIM_BLOCK,
+                   sumTuned / SIM_BLOCK, FIXED_FWD_MS + FIXED_LOCK_MS);
+            sumT = sumF = sumL = sumD = sumTuned = 0;
+            cut = 0;
+        }
+    }
+    printf("tuned from card %d; fixed %u ms would have cut %d of %d flings short\r\n\r\n",
+           warm, FIXED_FWD_MS, cutFixed, SIM_CARDS);
+}
+
+int main(void) {
+    Run(170.0, 240.0);      /* typical roller */
+    Run(110.0, 300.0);      /* strong new roller that wears out */
+    return 0;
+}
+#endif  /* MOTOR_TUNE_TEST */
@@ -0,0 +1,56 @@
+/* MotorTune.h */
+
+#ifndef MOTOR_TUNE_H
+#define MOTOR_TUNE_H
+
+#include <stdint.h>
+
+/* Feed-motor timing in use on this unit */
+typedef struct {
+    uint16_t fwdMs;         /* fling length (open loop) or timeout (encoder) */
+    uint16_t lockMs;        /* tuck length or timeout */
+    uint16_t nudgeMs;       /* sweep-boundary / idle tuck */
+    uint16_t duty;          /* PWM duty for fling and tuck, 0..MAX_PWM */
+} MotorTune_t;
+
+/**
+ * @brief   Start from 'start' (the stored values, or the compile-time
+ *          defaults), clamped to the safe bounds. Statistics start empty.
+ */
+void               MotorTune_Init(const MotorTune_t *start);
+
+/**
+ * @brief   Values to use for the next card.
+ */
+const MotorTune_t *MotorTune_Get(void);
+
+/**
+ * @brief   1 = leave the duty alone (no fling-time band, no stall step),
+ *          for when SpeedCtl regulates the roller speed; 0 = tune it.
+ */
+void               MotorTune_FixDuty(uint8_t fixed);
+
+/**
+ * @brief   A fling ended after ms. 'reached' is 1 if the encoder counted the
+ *          whole card out, 0 if the fling ran into its timeout first.
+ */
+void               MotorTune_Eject(uint16_t ms, uint8_t reached);
+
+/**
+ * @brief   A tuck ended after ms; 'reached' as for MotorTune_Eject().
+ */
+void               MotorTune_Lock(uint16_t ms, uint8_t reached);
+
+/**
+ * @brief   The motor stalled during a fling or tuck.
+ */
+void               MotorTune_Stall(void);
+
+/**
+ * @brief   Returns 1 if the values have moved far enough from 'saved' to be
+ *          worth a flash write (flash endurance is limited, so small drifts
+ *          are not saved).
+ */
+uint8_t            MotorTune_NeedsSave(const MotorTune_t *saved);
+
+#endif  /* MOTOR_TUNE_H */
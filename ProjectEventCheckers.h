@@ -4,9 +4,17 @@
 
 #include "SensorMotorEventChecker.h"
 #include "GameButton.h"
+#include "ServoMotion.h"
+#include "Encoder.h"
+#include "FeedMotor.h"
 
 uint8_t CheckDistance(void);
 uint8_t CheckMotor(void);
+uint8_t CheckSeatTrack(void);
 uint8_t CheckGameButton(void);
+uint8_t CheckServoMotion(void);
+uint8_t CheckEncoder(void);
+uint8_t CheckFeedMotor(void);
+uint8_t CheckADWindow(void);
 
 #endif  /* PROJECT_EVENT_CHECKERS_H */
@@ -0,0 +1,152 @@
+/* =============================================================================
+ * File:    RampShape.c
+ * Purpose: Ramp profiles for the PWM ramp engine in pwm.c, and the duty at
+ *          any point along one.
+ *
+ * Dependencies:
+ *   - none
+ *
+ * Behavior:
+ *   - A profile is a short table of points, 0 at the start duty and
+ *     RAMP_ONE at the target, spread evenly over the ramp time. Ramp_At()
+ *     interpolates linearly between the two points around tick n, so a
+ *     17-point table gives a smooth curve at any ramp length.
+ * =============================================================================
+ */
+#include <stdint.h>
+#include "RampShape.h"
+
+/* ????????? Profiles ????????? */
+static const uint16_t linearPts[] = {0, RAMP_ONE};
+/* 1 - e^(-5t), scaled so the last point is RAMP_ONE */
+static const uint16_t expPts[] = {
+    0, 277, 479, 627, 736, 815, 873, 915, 946,
+    969, 986, 998, 1007, 1013, 1018, 1021, RAMP_ONE
+};
+
+const RampProfile_t Ramp_Linear = {linearPts, sizeof linearPts / sizeof linearPts[0]};
+const RampProfile_t Ramp_Exp    = {expPts,    sizeof expPts / sizeof expPts[0]};
+
+uint16_t Ramp_At(const RampProfile_t *p, uint16_t from, uint16_t to,
+                 uint32_t n, uint32_t N) {
+    if (n >= N) {
+        return to;
+    }
+    /* position in segments, 8 fractional bits */
+    uint32_t pos  = (n * (uint32_t)(p->Count - 1u) << 8) / N;
+    uint32_t i    = pos >> 8, f = pos & 0xFFu;
+    uint32_t frac = (p->Points[i] * (256u - f) + p->Points[i + 1u] * f) >> 8;
+    int32_t  span = (int32_t)to - (int32_t)from;
+    return (uint16_t)(from + (span * (int32_t)frac) / (int32_t)RAMP_ONE);
+}
+
+/* ????????? Offline simulation ????????? */
+/*
+ * Build on a PC:  gcc -O2 -DRAMP_SHAPE_TEST -o rampshape RampShape.c -lm
+ * Run:            ./rampshape
+ *
+ * Simulates SIM_CARDS flings of one card with the feed motor started at
+ * full duty at once (no ramp) and along each built-in profile over several
+ * ramp lengths. Roller-side DC motor model, 0.1 ms Euler steps:
+ *   i = (d*Vbat - K*w) / R,   Vbat = Vcell - i*Rbat,
+ *   J dw/dt = K*i - B*w - load,
+ * with duty d updated once per PWM period (1 ms) as the Timer2 ISR would.
+ * Per card the cell voltage is drawn from SIM_V_LO..SIM_V_HI (state of
+ * charge) and the card drag from SIM_LOAD * (1 +- SIM_LOAD_VAR). The card
+ * leaves when the roller surface has moved SIM_EXIT_MM; the throw distance
+ * goes with the exit speed squared.
+ * Prints the mean peak motor current (inrush proxy), the lowest battery
+ * voltage the servo and sonar see, mean time to exit, and the coefficient
+ * of variation of throw distance across the cards. Every constant is an
+ * assumption for a small geared motor on the 3S LiFePO4 pack the firmware
+ * grades (BatMonitor: 8.5 V critical to 10.8 V full), not a measurement.
+ */
+#ifdef RAMP_SHAPE_TEST
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#define SIM_CARDS     2000
+#define SIM_DT        1e-4          /* s */
+#define SIM_PWM_S     1e-3          /* duty update period */
+#define SIM_V_LO      8.5           /* V, 3S LiFePO4 at rest: critical */
+#define SIM_V_HI      10.8          /* full */
+#define SIM_RBAT      0.35          /* ohm, cell + wiring */
+#define SIM_R         3.0           /* ohm, winding */
+#define SIM_K         0.30          /* V s/rad at the roller */
+#define SIM_J         8e-4          /* kg m^2 at the roller */
+#define SIM_B         2e-3          /* N m s/rad */
+#define SIM_LOAD      0.15          /* N m card drag */
+#define SIM_LOAD_VAR  0.25
+#define SIM_RADIUS    0.012         /* m */
+#define SIM_EXIT_MM   60.0
+
+typedef struct {
+    double peakA, minV, exitMs, dist;
+} Fling_t;
+
+static double Uniform(double lo, double hi) {
+    return lo + (hi - lo) * rand() / (double)RAND_MAX;
+}
+
+static Fling_t Fling(const RampProfile_t *p, uint32_t rampMs, double cell, double load) {
+    Fling_t r = {0, cell, 0, 0};
+    double w = 0, theta = 0, t = 0, duty = 0;
+    double exitRad = SIM_EXIT_MM / 1000.0 / SIM_RADIUS;
+    uint32_t tick = 0;
+    double nextTick = 0;
+    while (theta < exitRad && t < 2.0) {
+        if (t >= nextTick) {
+            duty = (p ? Ramp_At(p, 0, 1000, tick, rampMs) : 1000) / 1000.0;
+            tick++;
+            nextTick += SIM_PWM_S;
+        }
+        /* battery and winding in series: solve for the current */
+        double i = (duty * cell - SIM_K * w) / (SIM_R + duty * SIM_RBAT);
+        if (i < 0) i = 0;           /* bridge only drives, no regeneration */
+        double v = cell - duty * i * SIM_RBAT;
+        double torque = SIM_K * i - SIM_B * w - (w > 0 || SIM_K * i > load ? load : SIM_K * i);
+        w += torque / SIM_J * SIM_DT;
+        if (w < 0) w = 0;
+        theta += w * SIM_DT;
+        t += SIM_DT;
+        if (i > r.peakA) r.peakA = i;
+        if (v < r.minV) r.minV = v;
+    }
+    r.exitMs = t * 1000.0;
+    r.dist = pow(w * SIM_RADIUS, 2);
+    return r;
+}
+
+static void Row(const char *name, const RampProfile_t *p, uint32_t rampMs) {
+    double peak = 0, minV = 1e9, exitMs = 0, s = 0, s2 = 0;
+    srand(1);
+    for (int c = 0; c < SIM_CARDS; c++) {
+        double cell = Uniform(SIM_V_LO, SIM_V_HI);
+        double load = SIM_LOAD * Uniform(1.0 - SIM_LOAD_VAR, 1.0 + SIM_LOAD_VAR);
+        Fling_t f = Fling(p, rampMs, cell, load);
+        peak += f.peakA;
+        if (f.minV < minV) minV = f.minV;
+        exitMs += f.exitMs;
+        s += f.dist;
+        s2 += f.dist * f.dist;
+    }
+    double mean = s / SIM_CARDS;
+    double cv = sqrt(s2 / SIM_CARDS - mean * mean) / mean;
+    printf("%-7s %7u  %8.2f  %8.2f  %8.1f  %8.1f%%\r\n", name, rampMs,
+           peak / SIM_CARDS, minV, exitMs / SIM_CARDS, 100.0 * cv);
+}
+
+int main(void) {
+    static const uint32_t lens[] = {10, 20, 40, 80};
+    printf("profile ramp_ms  peak_A    min_Vbat  exit_ms   throw_cv\r\n");
+    Row("step", NULL, 0);
+    for (unsigned k = 0; k < sizeof lens / sizeof lens[0]; k++) {
+        Row("linear", &Ramp_Linear, lens[k]);
+    }
+    for (unsigned k = 0; k < sizeof lens / sizeof lens[0]; k++) {
+        Row("exp", &Ramp_Exp, lens[k]);
+    }
+    return 0;
+}
+#endif  /* RAMP_SHAPE_TEST */
@@ -0,0 +1,29 @@
+/* RampShape.h */
+
+#ifndef RAMP_SHAPE_H
+#define RAMP_SHAPE_H
+
+#include <stdint.h>
+
+/* Full scale of a ramp profile point: 0 = start duty, RAMP_ONE = target */
+#define RAMP_ONE   1024u
+
+/* Ramp profile: Count points (at least 2) from 0 to RAMP_ONE, evenly spaced
+   in time over the ramp; the duty is interpolated between them */
+typedef struct {
+    const uint16_t *Points;
+    uint8_t         Count;
+} RampProfile_t;
+
+/* Built-in profiles: straight line, and 1 - e^(-5t) (fast start, soft end) */
+extern const RampProfile_t Ramp_Linear;
+extern const RampProfile_t Ramp_Exp;
+
+/**
+ * @brief   Duty at tick n of an N-tick ramp from 'from' to 'to' along 'p'.
+ *          Returns 'to' for n >= N.
+ */
+uint16_t Ramp_At(const RampProfile_t *p, uint16_t from, uint16_t to,
+                 uint32_t n, uint32_t N);
+
+#endif  /* RAMP_SHAPE_H */
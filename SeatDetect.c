@@ -0,0 +1,372 @@
+/* =============================================================================
+ * File:    SeatDetect.c
+ * Purpose: Find the seats in one sonar scan of the table arc.
+ *
+ * Dependencies:
+ *   - none
+ *
+ * Behavior:
+ *   - The scan arrives one sample at a time in sweep order: servo pulse, sonar
+ *     range and whether the range is a hit (someone is there).
+ *   - A region opens after SEAT_OPEN_HITS hits in a row, so a single echo
+ *     spike never becomes a seat.
+ *   - Once open, the region only closes when no hit has been seen for
+ *     SEAT_GAP_US of pulse width. Drop-outs shorter than that are bridged,
+ *     which merges the two halves of one player instead of reporting two.
+ *   - A closed region wider than SEAT_NOMINAL_US is split evenly into as many
+ *     whole seats as fit, for players sitting shoulder to shoulder.
+ *   - Seat centre is the middle of the hit extent, not the leading edge.
+ *     Confidence is the share of samples in that extent that hit, scaled down
+ *     for seats narrower than SEAT_MIN_US. Seats under SEAT_MIN_CONF are dropped.
+ * =============================================================================
+ */
+#include <stdint.h>
+#include "SeatDetect.h"
+
+/* ????????? Tunables ????????? */
+/* Consecutive hits needed before a region opens */
+#define SEAT_OPEN_HITS   2u
+/* Hit-free stretch (us of pulse width) that closes an open region */
+#define SEAT_GAP_US      100u
+/* Typical angular width of one seated player; wider regions are split */
+#define SEAT_NOMINAL_US  300u
+/* Regions narrower than this get proportionally less confidence */
+#define SEAT_MIN_US      60u
+/* Seats below this confidence (0..100) are not reported */
+#define SEAT_MIN_CONF    40u
+
+/* ????????? Module State ????????? */
+static Seat_t   seats[SEAT_MAX];
+static uint8_t  nSeats;
+
+/* Region being built: run counts hits until it opens */
+static uint8_t  run;
+static uint8_t  isOpen;
+static uint16_t loUs, hiUs, lastHitUs;
+static uint16_t hits, samples, missRun;
+static uint32_t rangeSum;
+
+static inline uint16_t DistUs(uint16_t a, uint16_t b) {
+    return (a > b) ? a - b : b - a;
+}
+
+/**
+ * CloseRegion()
+ *   Turns the region in progress into one or more seats.
+ *   Returns the index of the first new seat, or SEAT_NONE.
+ */
+static uint8_t CloseRegion(void) {
+    uint8_t first = SEAT_NONE;
+    uint16_t width = hiUs - loUs;
+    uint8_t  n = (uint8_t)(width / SEAT_NOMINAL_US);
+    if (n == 0) {
+        n = 1;
+    }
+    uint16_t part = width / n;
+    uint8_t  conf = (uint8_t)((uint32_t)hits * 100u / samples);
+    if (part < SEAT_MIN_US) {
+        conf = (uint8_t)((uint32_t)conf * part / SEAT_MIN_US);
+    }
+
+    for (uint8_t k = 0; k < n && conf >= SEAT_MIN_CONF && nSeats < SEAT_MAX; k++) {
+        Seat_t *s = &seats[nSeats];
+        s->centreUs   = loUs + part * k + part / 2;
+        s->widthUs    = part;
+        s->rangeCm    = (uint16_t)(rangeSum / hits);
+        s->confidence = conf;
+        if (first == SEAT_NONE) {
+            first = nSeats;
+        }
+        nSeats++;
+    }
+    run = isOpen = 0;
+    return first;
+}
+
+void SeatDetect_Begin(void) {
+    nSeats = 0;
+    run = isOpen = 0;
+}
+
+uint8_t SeatDetect_AddSample(uint16_t pulseUs, uint16_t cm, uint8_t hit) {
+    if (hit) {
+        if (run == 0 && !isOpen) {
+            /* first hit of a candidate region */
+            loUs = hiUs = pulseUs;
+            hits = samples = 0;
+            missRun = 0;
+            rangeSum = 0;
+        }
+        if (pulseUs < loUs) loUs = pulseUs;
+        if (pulseUs > hiUs) hiUs = pulseUs;
+        lastHitUs = pulseUs;
+        hits++;
+        samples += missRun + 1u;    /* bridged misses count against confidence */
+        missRun = 0;
+        rangeSum += cm;
+        if (!isOpen && ++run >= SEAT_OPEN_HITS) {
+            isOpen = 1;
+        }
+        return SEAT_NONE;
+    }
+
+    if (!isOpen) {
+        run = 0;                    /* hits were not consecutive: drop them */
+        return SEAT_NONE;
+    }
+    missRun++;
+    if (DistUs(pulseUs, lastHitUs) >= SEAT_GAP_US) {
+        return CloseRegion();
+    }
+    return SEAT_NONE;
+}
+
+uint8_t SeatDetect_Finish(void) {
+    if (isOpen) {
+        CloseRegion();
+    }
+    run = 0;
+    return nSeats;
+}
+
+uint8_t SeatDetect_Count(void) {
+    return nSeats;
+}
+
+const Seat_t *SeatDetect_Get(uint8_t i) {
+    return &seats[i];
+}
+
+uint8_t SeatDetect_Windows(uint16_t marginUs, uint16_t minUs, uint16_t maxUs,
+                           SeatWindow_t *win) {
+    uint8_t n = 0;
+    for (uint8_t i = 0; i < nSeats; i++) {
+        const Seat_t *s = &seats[i];
+        uint16_t lo = s->centreUs - s->widthUs / 2;
+        uint16_t hi = lo + s->widthUs;
+        lo = (lo > minUs + marginUs) ? lo - marginUs : minUs;
+        hi = (hi + marginUs < maxUs) ? hi + marginUs : maxUs;
+
+        /* insert in ascending order of loUs */
+        uint8_t j = n;
+        while (j > 0 && win[j - 1].loUs > lo) {
+            win[j] = win[j - 1];
+            j--;
+        }
+        win[j].loUs = lo;
+        win[j].hiUs = hi;
+        n++;
+    }
+
+    /* merge overlapping neighbours */
+    uint8_t m = 0;
+    for (uint8_t i = 0; i < n; i++) {
+        if (m && win[i].loUs <= win[m - 1].hiUs) {
+            if (win[i].hiUs > win[m - 1].hiUs) {
+                win[m - 1].hiUs = win[i].hiUs;
+            }
+        } else {
+            win[m++] = win[i];
+        }
+    }
+    return m;
+}
+
+/* ????????? Scan file loader (host builds) ????????? */
+#if defined(SEAT_DETECT_TEST) || defined(BASELINE_TEST)
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+int SeatDetect_LoadScan(const char *fn, uint16_t *pulse, uint16_t *cm, int max,
+                        uint16_t *truth, int *nt) {
+    FILE *f = fopen(fn, "r");
+    char line[128];
+    int n = 0;
+    *nt = 0;
+    if (!f) {
+        return -1;
+    }
+    while (fgets(line, sizeof line, f) && n < max) {
+        unsigned p, c;
+        if (strncmp(line, "#truth", 6) == 0) {
+            char *tok = strtok(line + 6, " \t\r\n");
+            while (tok && *nt < SEAT_MAX) {
+                truth[(*nt)++] = (uint16_t)atoi(tok);
+                tok = strtok(NULL, " \t\r\n");
+            }
+        } else if (sscanf(line, "%u,%u", &p, &c) == 2) {
+            pulse[n] = (uint16_t)p;
+            cm[n++]  = (uint16_t)c;
+        }
+    }
+    fclose(f);
+    return n;
+}
+#endif
+
+/* ????????? Offline harness ????????? */
+/*
+ * Build on a PC:  gcc -O2 -DSEAT_DETECT_TEST -o seatdetect SeatDetect.c
+ * Run:            ./seatdetect [-t cm] [-c us] [-r us] scan1.csv [scan2.csv ...]
+ *
+ * Each scan file holds one sweep, one "pulse,cm" sample per line, starting
+ * after the warm-up steps. An optional "#truth <us> <us> ..." line gives the
+ * measured seat centres. For each scan the harness prints the seats found,
+ * the mean centre error against truth for this detector and for the old
+ * first-near-edge rule, and the time spent per sample. A sample is a hit when
+ * cm >= the -t threshold (default 30, same as NEAR_CM).
+ *
+ * With -c the harness also replays a coarse-to-fine calibration from the
+ * same samples: a coarse pass using every sample that lands on the -c step,
+ * then the samples inside the refinement windows (-r margin, default 100).
+ * It compares those centres with the single-pass ones and prints the step
+ * count of each method, plus a time estimate from the STEP_MS/CAL_FINE_MS
+ * constants below. Servo seeks between windows are not in the estimate.
+ */
+#ifdef SEAT_DETECT_TEST
+#include <time.h>
+
+#define MAX_SAMPLES  1024
+#define LEGACY_SEP   250u        /* MIN_SEP_US of the old calibration rule */
+#define REPS         2000
+#define SIM_STEP_MS  70u         /* STEP_MS: single pass and coarse step period */
+#define SIM_FINE_MS  40u         /* CAL_FINE_MS: refinement step period */
+
+static uint16_t sPulse[MAX_SAMPLES], sCm[MAX_SAMPLES];
+static uint16_t truth[SEAT_MAX];
+
+/* Mean |error| from each true centre to the nearest detected centre */
+static float MeanError(const uint16_t *found, int nf, int nt) {
+    float sum = 0.0f;
+    if (nf == 0 || nt == 0) {
+        return -1.0f;
+    }
+    for (int t = 0; t < nt; t++) {
+        uint16_t best = 0xFFFF;
+        for (int f = 0; f < nf; f++) {
+            uint16_t d = DistUs(found[f], truth[t]);
+            if (d < best) best = d;
+        }
+        sum += best;
+    }
+    return sum / nt;
+}
+
+/* Replay a coarse pass plus refinement windows; returns seats in found[] */
+static int CoarseFine(int n, uint16_t thresh, uint16_t coarse, uint16_t margin,
+                      uint16_t *found, int *steps) {
+    SeatWindow_t win[SEAT_MAX];
+    int nc = 0, nr = 0;
+
+    SeatDetect_Begin();
+    for (int i = 0; i < n; i++) {
+        if ((uint16_t)(sPulse[i] - sPulse[0]) % coarse == 0) {
+            SeatDetect_AddSample(sPulse[i], sCm[i], sCm[i] >= thresh);
+            nc++;
+        }
+    }
+    SeatDetect_Finish();
+    uint8_t nw = SeatDetect_Windows(margin, sPulse[0], sPulse[n - 1], win);
+
+    SeatDetect_Begin();
+    for (uint8_t w = 0; w < nw; w++) {
+        for (int i = 0; i < n; i++) {
+            if (sPulse[i] >= win[w].loUs && sPulse[i] <= win[w].hiUs) {
+                SeatDetect_AddSample(sPulse[i], sCm[i], sCm[i] >= thresh);
+                nr++;
+            }
+        }
+        SeatDetect_Finish();
+    }
+    int nf = SeatDetect_Count();
+    for (int i = 0; i < nf; i++) {
+        found[i] = SeatDetect_Get(i)->centreUs;
+    }
+    steps[0] = nc;
+    steps[1] = nr;
+    return nf;
+}
+
+int main(int argc, char **argv) {
+    uint16_t thresh = 30, coarse = 0, margin = 100;
+    int a = 1;
+    while (a + 1 < argc && argv[a][0] == '-') {
+        if (strcmp(argv[a], "-t") == 0) thresh = (uint16_t)atoi(argv[a + 1]);
+        if (strcmp(argv[a], "-c") == 0) coarse = (uint16_t)atoi(argv[a + 1]);
+        if (strcmp(argv[a], "-r") == 0) margin = (uint16_t)atoi(argv[a + 1]);
+        a += 2;
+    }
+    if (a >= argc) {
+        printf("usage: %s [-t cm] [-c us] [-r us] scan.csv ...\r\n", argv[0]);
+        return 1;
+    }
+
+    for (; a < argc; a++) {
+        int nt;
+        int n = SeatDetect_LoadScan(argv[a], sPulse, sCm, MAX_SAMPLES, truth, &nt);
+        if (n < 0) {
+            printf("%s: cannot open\r\n", argv[a]);
+            continue;
+        }
+
+        /* segmentation */
+        uint16_t found[SEAT_MAX];
+        SeatDetect_Begin();
+        for (int i = 0; i < n; i++) {
+            SeatDetect_AddSample(sPulse[i], sCm[i], sCm[i] >= thresh);
+        }
+        int nf = SeatDetect_Finish();
+        printf("%s: %d samples, %d seats\r\n", argv[a], n, nf);
+        for (int i = 0; i < nf; i++) {
+            const Seat_t *s = SeatDetect_Get(i);
+            found[i] = s->centreUs;
+            printf("  seat %d centre=%u width=%u range=%u conf=%u\r\n",
+                   i + 1, s->centreUs, s->widthUs, s->rangeCm, s->confidence);
+        }
+
+        /* old rule: first near edge, at least LEGACY_SEP after the last player */
+        uint16_t legacy[SEAT_MAX];
+        int nl = 0;
+        for (int i = 0; i < n && nl < SEAT_MAX; i++) {
+            uint8_t edge = sCm[i] >= thresh && (i == 0 || sCm[i - 1] < thresh);
+            if (edge && (nl == 0 || (uint16_t)(sPulse[i] - legacy[nl - 1]) > LEGACY_SEP)) {
+                legacy[nl++] = sPulse[i];
+            }
+        }
+
+        if (nt) {
+            printf("  truth=%d  err_us: segment=%.1f legacy=%.1f (legacy found %d)\r\n",
+                   nt, MeanError(found, nf, nt), MeanError(legacy, nl, nt), nl);
+        }
+
+        /* CPU cost per sample */
+        clock_t t0 = clock();
+        for (int r = 0; r < REPS; r++) {
+            SeatDetect_Begin();
+            for (int i = 0; i < n; i++) {
+                SeatDetect_AddSample(sPulse[i], sCm[i], sCm[i] >= thresh);
+            }
+            SeatDetect_Finish();
+        }
+        double ns = (double)(clock() - t0) * 1e9 / CLOCKS_PER_SEC / ((double)REPS * (n ? n : 1));
+        printf("  %.1f ns/sample (host)\r\n", ns);
+
+        if (coarse && n) {
+            uint16_t fine[SEAT_MAX];
+            int steps[2];
+            int nc = CoarseFine(n, thresh, coarse, margin, fine, steps);
+            /* compare against the single-pass centres found above */
+            for (int i = 0; i < nf; i++) {
+                truth[i] = found[i];
+            }
+            printf("  coarse-fine: %d seats, err_vs_single_us=%.1f\r\n",
+                   nc, MeanError(fine, nc, nf));
+            printf("  steps single=%d coarse=%d refine=%d  est_ms single=%u coarse-fine=%u\r\n",
+                   n, steps[0], steps[1], (unsigned)(n * SIM_STEP_MS),
+                   (unsigned)(steps[0] * SIM_STEP_MS + steps[1] * SIM_FINE_MS));
+        }
+    }
+    return 0;
+}
+#endif  /* SEAT_DETECT_TEST */
@@ -0,0 +1,79 @@
+/* SeatDetect.h */
+
+#ifndef SEAT_DETECT_H
+#define SEAT_DETECT_H
+
+#include <stdint.h>
+
+/* Most seats one scan can report */
+#define SEAT_MAX         10
+/* Returned by SeatDetect_AddSample() when no seat was completed */
+#define SEAT_NONE    0xFF
+
+typedef struct {
+    uint16_t centreUs;      /* servo pulse width at the middle of the seat */
+    uint16_t widthUs;       /* angular extent of the seat, in us of pulse width */
+    uint16_t rangeCm;       /* mean sonar range of the samples that hit */
+    uint8_t  confidence;    /* 0..100, share of the region's samples that hit */
+} Seat_t;
+
+typedef struct {
+    uint16_t loUs;          /* first pulse of a refinement window */
+    uint16_t hiUs;          /* last pulse of a refinement window */
+} SeatWindow_t;
+
+/**
+ * @brief   Start a new scan. Clears all seats and any region in progress.
+ */
+void          SeatDetect_Begin(void);
+
+/**
+ * @brief   Feed one sample of the scan: the servo pulse it was taken at, the
+ *          sonar range and whether that range counts as a hit.
+ *          Samples must arrive in sweep order (either direction).
+ * @return  Index of the first seat completed by this sample, or SEAT_NONE.
+ *          A region that gets split completes several seats at once; use
+ *          SeatDetect_Count() to see how many there are now.
+ */
+uint8_t       SeatDetect_AddSample(uint16_t pulseUs, uint16_t cm, uint8_t hit);
+
+/**
+ * @brief   End the scan, closing a region still open at the end of the arc.
+ *          Seats are kept, so this may also be called at the end of each
+ *          window of a windowed scan; the next sample starts a new region.
+ * @return  Number of seats found.
+ */
+uint8_t       SeatDetect_Finish(void);
+
+/**
+ * @brief   Number of seats found so far in this scan.
+ */
+uint8_t       SeatDetect_Count(void);
+
+/**
+ * @brief   Seat i of the scan (0 <= i < SeatDetect_Count()), in sweep order.
+ */
+const Seat_t *SeatDetect_Get(uint8_t i);
+
+/**
+ * @brief   Turn the seats found so far into refinement windows: each seat's
+ *          extent widened by marginUs on both sides and clipped to
+ *          [minUs, maxUs]. Windows come out in ascending order and
+ *          overlapping ones are merged.
+ * @return  Number of windows written to win[] (at most SEAT_MAX).
+ */
+uint8_t       SeatDetect_Windows(uint16_t marginUs, uint16_t minUs, uint16_t maxUs,
+                                 SeatWindow_t *win);
+
+#if defined(SEAT_DETECT_TEST) || defined(BASELINE_TEST)
+/**
+ * @brief   Host harnesses only: read a scan file, "pulse,cm" per line plus an
+ *          optional "#truth <us> <us> ..." line, into pulse[]/cm[] (at most
+ *          'max' samples) and truth[] (at most SEAT_MAX, count in *nt).
+ * @return  Number of samples read, or -1 if the file cannot be opened.
+ */
+int           SeatDetect_LoadScan(const char *fn, uint16_t *pulse, uint16_t *cm, int max,
+                                  uint16_t *truth, int *nt);
+#endif
+
+#endif  /* SEAT_DETECT_H */
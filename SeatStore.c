@@ -0,0 +1,145 @@
+/* =============================================================================
+ * File:    SeatStore.c
+ * Purpose: Keep the last seat calibration in a reserved page of program flash.
+ *
+ * Dependencies:
+ *   - xc.h            - NVMCON / NVMKEY / NVMADDR / NVMDATA
+ *   - BOARD.h         - BOARD_GetPBClock() for the LVD start-up delay
+ *
+ * Layout of the page (32-bit words):
+ *   [0] STORE_MAGIC
+ *   [1] STORE_VERSION << 16 | payload length in bytes
+ *   [2] CRC-16/CCITT of the payload
+ *   [3...] SeatRecord_t, padded to whole words
+ *   An erased page (all 0xFFFFFFFF) has no magic and reads as "no record".
+ *   Bump STORE_VERSION whenever SeatRecord_t changes so old pages are ignored.
+ *
+ * Flash operations use the NVM unlock sequence with interrupts disabled.
+ * The CPU stalls while a page erase runs (about 20 ms), so only save between
+ * hands, never while the motor is running.
+ * =============================================================================
+ */
+#include <xc.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "BOARD.h"
+#include "SeatStore.h"
+
+/* ????????? Layout ????????? */
+#define PAGE_BYTES      4096u           /* PIC32MX erase page */
+#define PAGE_WORDS      (PAGE_BYTES / 4u)
+#define STORE_MAGIC     0x53454154u     /* "SEAT" */
+#define STORE_VERSION   4u
+#define HDR_WORDS       3u
+#define REC_WORDS       ((sizeof(SeatRecord_t) + 3u) / 4u)
+
+/* ????????? NVM operations ????????? */
+#define NVMOP_WORD_PGM   0x1u
+#define NVMOP_PAGE_ERASE 0x4u
+#define NVM_KEY1         0xAA996655u
+#define NVM_KEY2         0x556699AAu
+/* Physical address of a KSEG0/KSEG1 pointer, as NVMADDR wants it */
+#define KVA_TO_PHYS(p)   ((uint32_t)(p) & 0x1FFFFFFFu)
+
+/* The reserved page; initialised erased so a fresh image reads as empty */
+static const uint32_t __attribute__((aligned(PAGE_BYTES), space(prog)))
+    storePage[PAGE_WORDS] = { [0 ... PAGE_WORDS - 1] = 0xFFFFFFFFu };
+
+/* Always read the page through this so the compiler cannot fold the
+   initialiser into the reads */
+static const volatile uint32_t *const page = storePage;
+
+static uint16_t Crc16(const uint8_t *p, uint16_t n) {
+    uint16_t crc = 0xFFFF;
+    while (n--) {
+        crc ^= (uint16_t)(*p++) << 8;
+        for (uint8_t b = 0; b < 8; b++) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+/**
+ * NvmOp(op)
+ *   Runs one NVM operation on NVMADDR with the unlock sequence.
+ *   Returns 1 if neither WRERR nor LVDERR was set.
+ */
+static uint8_t NvmOp(uint32_t op) {
+    uint32_t status = __builtin_disable_interrupts();
+    NVMCON = _NVMCON_WREN_MASK | op;
+    /* low-voltage detect needs 6 us to start after WREN; the core timer
+       runs at SYSCLK/2, the same rate as the PB clock */
+    uint32_t start = _CP0_GET_COUNT();
+    while (_CP0_GET_COUNT() - start < (BOARD_GetPBClock() / 1000000) * 6) {
+    }
+    NVMKEY = NVM_KEY1;
+    NVMKEY = NVM_KEY2;
+    NVMCONSET = _NVMCON_WR_MASK;
+    while (NVMCON & _NVMCON_WR_MASK) {
+    }
+    NVMCONCLR = _NVMCON_WREN_MASK;
+    if (status & _CP0_STATUS_IE_MASK) {
+        __builtin_enable_interrupts();
+    }
+    return (NVMCON & (_NVMCON_WRERR_MASK | _NVMCON_LVDERR_MASK)) == 0;
+}
+
+static uint8_t ErasePage(void) {
+    NVMADDR = KVA_TO_PHYS(storePage);
+    return NvmOp(NVMOP_PAGE_ERASE);
+}
+
+static uint8_t WriteWord(uint16_t i, uint32_t w) {
+    NVMADDR = KVA_TO_PHYS(&storePage[i]);
+    NVMDATA = w;
+    return NvmOp(NVMOP_WORD_PGM);
+}
+
+/* Image: header followed by the record, as it should appear in flash */
+static void BuildImage(const SeatRecord_t *rec, uint32_t *img) {
+    memset(img, 0, (HDR_WORDS + REC_WORDS) * 4u);
+    memcpy(&img[HDR_WORDS], rec, sizeof(SeatRecord_t));
+    img[0] = STORE_MAGIC;
+    img[1] = (STORE_VERSION << 16) | sizeof(SeatRecord_t);
+    img[2] = Crc16((const uint8_t *)&img[HDR_WORDS], sizeof(SeatRecord_t));
+}
+
+uint8_t SeatStore_Load(SeatRecord_t *rec) {
+    uint32_t img[HDR_WORDS + REC_WORDS];
+    for (uint16_t i = 0; i < HDR_WORDS + REC_WORDS; i++) {
+        img[i] = page[i];
+    }
+    if (img[0] != STORE_MAGIC ||
+        img[1] != ((STORE_VERSION << 16) | sizeof(SeatRecord_t)) ||
+        img[2] != Crc16((const uint8_t *)&img[HDR_WORDS], sizeof(SeatRecord_t))) {
+        return 0;
+    }
+    memcpy(rec, &img[HDR_WORDS], sizeof(SeatRecord_t));
+    return rec->count <= SEAT_MAX;
+}
+
+uint8_t SeatStore_Save(const SeatRecord_t *rec) {
+    uint32_t img[HDR_WORDS + REC_WORDS];
+    uint16_t i;
+    BuildImage(rec, img);
+
+    /* Skip the erase cycle if nothing changed */
+    for (i = 0; i < HDR_WORDS + REC_WORDS && page[i] == img[i]; i++) {
+    }
+    if (i == HDR_WORDS + REC_WORDS) {
+        return 1;
+    }
+
+    if (!ErasePage()) {
+        return 0;
+    }
+    /* Payload first, magic last: a reset part-way leaves no valid header */
+    for (i = HDR_WORDS + REC_WORDS; i-- > 0; ) {
+        if (!WriteWord(i, img[i]) || page[i] != img[i]) {
+            return 0;
+        }
+    }
+    return 1;
+}
@@ -0,0 +1,36 @@
+/* SeatStore.h */
+
+#ifndef SEAT_STORE_H
+#define SEAT_STORE_H
+
+#include <stdint.h>
+#include "SeatDetect.h"
+#include "MotorTune.h"
+#include "Baseline.h"
+
+/* Calibration result kept across power cycles */
+typedef struct {
+    uint8_t  count;                 /* number of seats below; 0 = none stored */
+    uint16_t angleUs[SEAT_MAX];     /* seat centres, ascending */
+    uint16_t widthUs[SEAT_MAX];     /* seat widths from the scan */
+    MotorTune_t tune;               /* feed-motor timing learned by this unit */
+    uint8_t  baseValid;             /* 1 = baseCm holds an empty-table baseline */
+    uint16_t baseCm[BASE_BINS];     /* the seats above were found against it */
+} SeatRecord_t;
+
+/**
+ * @brief   Read the stored calibration.
+ * @return  1 if the flash page holds a record with the right magic, version
+ *          and CRC (rec is filled in), else 0.
+ */
+uint8_t  SeatStore_Load(SeatRecord_t *rec);
+
+/**
+ * @brief   Erase the reserved flash page and write rec to it. Does nothing if
+ *          the page already holds exactly this record.
+ *          Interrupts are held off while each flash operation runs.
+ * @return  1 if the record reads back intact, else 0.
+ */
+uint8_t  SeatStore_Save(const SeatRecord_t *rec);
+
+#endif  /* SEAT_STORE_H */
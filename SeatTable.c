@@ -0,0 +1,230 @@
+/* =============================================================================
+ * File:    SeatTable.c
+ * Purpose: Seats at the table and the cards each one is still owed.
+ *
+ * Dependencies:
+ *   - none
+ *
+ * Layout:
+ *   - Struct of arrays: one column each for angle, width and cards remaining,
+ *     kept in ascending angle order.
+ *   - need:  bit i set while seat i still needs cards this hand.
+ *   - owed:  bit i set while seat i is still owed its card this round. When
+ *     it empties, the round is over and it reloads from need.
+ *   - The next seat to deal is found from need with count-trailing-zeros,
+ *     so the cost doesn't grow with the number of seats.
+ * =============================================================================
+ */
+#include <stdint.h>
+#include "SeatTable.h"
+
+/* ????????? Module State ????????? */
+static uint16_t angle[SEAT_TABLE_MAX];
+static uint16_t width[SEAT_TABLE_MAX];
+static uint8_t  remain[SEAT_TABLE_MAX];
+static uint8_t  count;
+static uint16_t need;
+static uint16_t owed;
+
+/* Index of the lowest set bit; m must not be 0 */
+static inline uint8_t LowestBit(uint16_t m) {
+    return (uint8_t)__builtin_ctz(m);
+}
+
+/* Clear seat i from this round; returns 1 if that ended the round */
+static uint8_t EndTurn(uint8_t i) {
+    owed &= (uint16_t)~(1u << i);
+    if (owed == 0) {
+        owed = need;
+        return 1;
+    }
+    return 0;
+}
+
+void SeatTable_Clear(void) {
+    count = 0;
+    need = owed = 0;
+}
+
+uint8_t SeatTable_Add(uint16_t angleUs, uint16_t widthUs) {
+    if (count >= SEAT_TABLE_MAX) {
+        return SEAT_TABLE_NONE;
+    }
+    /* insertion from the top: scans come in ascending, so usually no moves */
+    uint8_t j = count;
+    while (j > 0 && angle[j - 1] > angleUs) {
+        angle[j]  = angle[j - 1];
+        width[j]  = width[j - 1];
+        remain[j] = remain[j - 1];
+        j--;
+    }
+    angle[j]  = angleUs;
+    width[j]  = widthUs;
+    remain[j] = 0;
+    count++;
+    return j;
+}
+
+uint8_t SeatTable_Count(void) {
+    return count;
+}
+
+uint16_t SeatTable_Angle(uint8_t i) {
+    return angle[i];
+}
+
+uint16_t SeatTable_Width(uint8_t i) {
+    return width[i];
+}
+
+uint8_t SeatTable_Remain(uint8_t i) {
+    return remain[i];
+}
+
+const uint16_t *SeatTable_Angles(void) {
+    return angle;
+}
+
+const uint16_t *SeatTable_Widths(void) {
+    return width;
+}
+
+void SeatTable_StartHand(uint8_t cards) {
+    for (uint8_t i = 0; i < count; i++) {
+        remain[i] = cards;
+    }
+    need = (cards && count) ? (uint16_t)((1u << count) - 1u) : 0;
+    owed = need;
+}
+
+uint8_t SeatTable_Deal(uint8_t i, uint8_t cards) {
+    remain[i] = (remain[i] > cards) ? remain[i] - cards : 0;
+    if (remain[i] == 0) {
+        need &= (uint16_t)~(1u << i);
+    }
+    return EndTurn(i);
+}
+
+uint8_t SeatTable_Drop(uint8_t i) {
+    remain[i] = 0;
+    need &= (uint16_t)~(1u << i);
+    return EndTurn(i);
+}
+
+uint8_t SeatTable_AllDealt(void) {
+    return need == 0;
+}
+
+uint8_t SeatTable_Next(uint8_t i) {
+    if (need == 0) {
+        return SEAT_TABLE_NONE;
+    }
+    /* seats above i first, then wrap to the lowest */
+    uint16_t above = (i == SEAT_TABLE_NONE) ? need
+                                            : need & (uint16_t)~((2u << i) - 1u);
+    return LowestBit(above ? above : need);
+}
+
+uint8_t SeatTable_FirstOwed(int8_t dir) {
+    if (owed == 0) {
+        return SEAT_TABLE_NONE;
+    }
+    return (dir > 0) ? LowestBit(owed) : (uint8_t)(31 - __builtin_clz(owed));
+}
+
+uint16_t SeatTable_OwedMask(void) {
+    return owed;
+}
+
+/* ????????? Benchmark harness ????????? */
+/*
+ * Build on a PC:  gcc -O2 -DSEAT_TABLE_TEST -o seattable SeatTable.c
+ * Run:            ./seattable
+ *
+ * For 4, 8 and 10 seats, deals a 7-card hand many times. Each card costs
+ * one round of per-deal bookkeeping, once with the seat table and once with
+ * the old parallel arrays (modulo-scan AdvanceIdx, AllDealt loop, CountRound
+ * recount). Prints the host ns per card and the RAM each layout needs for
+ * that many seats.
+ */
+#ifdef SEAT_TABLE_TEST
+#include <stdio.h>
+#include <time.h>
+
+#define REPS   200000
+#define CARDS  7
+
+/* The old bookkeeping, as it was in CardDealerHSM.c */
+static uint8_t  oldRemain[SEAT_TABLE_MAX];
+static uint8_t  oldPlayers, oldIdx, oldRoundLeft;
+
+static int OldAllDealt(void) {
+    for (uint8_t i = 0; i < oldPlayers; i++) {
+        if (oldRemain[i]) return 0;
+    }
+    return 1;
+}
+
+static void OldCountRound(void) {
+    if (oldRoundLeft && --oldRoundLeft == 0) {
+        for (uint8_t i = 0; i < oldPlayers; i++) {
+            if (oldRemain[i]) oldRoundLeft++;
+        }
+    }
+}
+
+static void OldAdvanceIdx(void) {
+    do {
+        oldIdx = (oldIdx + 1) % oldPlayers;
+    } while (oldRemain[oldIdx] == 0);
+}
+
+int main(void) {
+    static const uint8_t sizes[] = {4, 8, 10};
+    volatile uint32_t sink = 0;
+
+    for (uint8_t s = 0; s < sizeof sizes; s++) {
+        uint8_t n = sizes[s];
+        long cards = (long)REPS * n * CARDS;
+
+        SeatTable_Clear();
+        for (uint8_t i = 0; i < n; i++) {
+            SeatTable_Add(1000 + 150 * i, 100);
+        }
+        clock_t t0 = clock();
+        for (long r = 0; r < REPS; r++) {
+            SeatTable_StartHand(CARDS);
+            uint8_t i = SeatTable_Next(SEAT_TABLE_NONE);
+            while (i != SEAT_TABLE_NONE) {
+                sink += SeatTable_Deal(i, 1);
+                i = SeatTable_Next(i);
+            }
+        }
+        double tNew = (double)(clock() - t0) * 1e9 / CLOCKS_PER_SEC / cards;
+
+        oldPlayers = n;
+        t0 = clock();
+        for (long r = 0; r < REPS; r++) {
+            for (uint8_t i = 0; i < n; i++) oldRemain[i] = CARDS;
+            oldIdx = 0;
+            oldRoundLeft = n;
+            for (;;) {
+                --oldRemain[oldIdx];
+                OldCountRound();
+                if (OldAllDealt()) break;
+                OldAdvanceIdx();
+            }
+            sink += oldIdx;
+        }
+        double tOld = (double)(clock() - t0) * 1e9 / CLOCKS_PER_SEC / cards;
+
+        /* angle + width + remain per seat; new adds two 16-bit masks and a
+           count, old adds players, idx and roundLeft */
+        unsigned ramNew = n * (2 + 2 + 1) + 2 + 2 + 1;
+        unsigned ramOld = n * (2 + 2 + 1) + 1 + 1 + 1;
+        printf("seats=%2u  ns/card: table=%.1f old=%.1f  RAM bytes: table=%u old=%u\r\n",
+               n, tNew, tOld, ramNew, ramOld);
+    }
+    return (int)(sink & 0);
+}
+#endif  /* SEAT_TABLE_TEST */
@@ -0,0 +1,80 @@
+/* SeatTable.h */
+
+#ifndef SEAT_TABLE_H
+#define SEAT_TABLE_H
+
+#include <stdint.h>
+
+/* Most seats at the table; the need masks are 16 bits wide */
+#define SEAT_TABLE_MAX   10
+/* Returned by SeatTable_Add() and SeatTable_Next() when there is no seat */
+#define SEAT_TABLE_NONE  0xFF
+
+/**
+ * @brief   Remove every seat.
+ */
+void            SeatTable_Clear(void);
+
+/**
+ * @brief   Add a seat, keeping the table in ascending angle order.
+ *          Seat indices of seats above the new one shift up by one.
+ * @return  Index of the new seat, or SEAT_TABLE_NONE if the table is full.
+ */
+uint8_t         SeatTable_Add(uint16_t angleUs, uint16_t widthUs);
+
+uint8_t         SeatTable_Count(void);
+uint16_t        SeatTable_Angle(uint8_t i);
+uint16_t        SeatTable_Width(uint8_t i);
+uint8_t         SeatTable_Remain(uint8_t i);
+
+/**
+ * @brief   The angle and width columns, SeatTable_Count() entries each.
+ */
+const uint16_t *SeatTable_Angles(void);
+const uint16_t *SeatTable_Widths(void);
+
+/**
+ * @brief   Give every seat 'cards' cards to receive and start the first round.
+ */
+void            SeatTable_StartHand(uint8_t cards);
+
+/**
+ * @brief   Seat i has had its turn and received 'cards' cards (more than one
+ *          when dealing in bursts).
+ * @return  1 if that completed a round (every seat still in the hand has had
+ *          its turn), else 0.
+ */
+uint8_t         SeatTable_Deal(uint8_t i, uint8_t cards);
+
+/**
+ * @brief   Take seat i out of the rest of the hand (its seat has emptied).
+ * @return  1 if that completed a round, as for SeatTable_Deal().
+ */
+uint8_t         SeatTable_Drop(uint8_t i);
+
+/**
+ * @brief   Returns 1 when no seat needs any more cards.
+ */
+uint8_t         SeatTable_AllDealt(void);
+
+/**
+ * @brief   Next seat after i (wrapping round) that still needs cards, in O(1)
+ *          from the need bitmask. Pass SEAT_TABLE_NONE to start from seat 0.
+ * @return  Seat index, or SEAT_TABLE_NONE if every card is out.
+ */
+uint8_t         SeatTable_Next(uint8_t i);
+
+/**
+ * @brief   Lowest (dir > 0) or highest (dir < 0) seat still owed a card this
+ *          round. Used to deal a round in one direction: after each deal the
+ *          seats behind are no longer owed, so this is the next one along.
+ * @return  Seat index, or SEAT_TABLE_NONE if every card is out.
+ */
+uint8_t         SeatTable_FirstOwed(int8_t dir);
+
+/**
+ * @brief   Bit i is set while seat i is still owed a card this round.
+ */
+uint16_t        SeatTable_OwedMask(void);
+
+#endif  /* SEAT_TABLE_H */
@@ -0,0 +1,222 @@
+/* =============================================================================
+ * File:    SeatTrack.c
+ * Purpose: Keep track of which calibrated seats are still occupied, and spot
+ *          new players, from the sonar readings taken while dealing.
+ *
+ * Dependencies:
+ *   - none
+ *
+ * Behavior:
+ *   - Each seat has a presence confidence (0..100) that starts at 100. A
+ *     settled hit inside the seat raises it by PRES_UP and a settled miss
+ *     lowers it by PRES_DOWN. The seat counts as present while the
+ *     confidence is at least PRES_MIN. With the defaults, two misses in a
+ *     row empty a seat and one hit brings it back.
+ *   - Readings more than NEW_MARGIN_US outside every seat go into
+ *     NEW_BIN_US wide bins. A hit adds to the bin and a miss takes one
+ *     away. The first time a bin reaches NEW_SEAT_HITS, its centre is
+ *     reported as a newly occupied spot. Moving readings count here: the
+ *     servo only stops at known seats.
+ * =============================================================================
+ */
+#include <stdint.h>
+#include "SeatTrack.h"
+
+/* ????????? Tunables ????????? */
+#define PRES_UP          25u
+#define PRES_DOWN        35u
+#define PRES_MIN         50u
+/* Servo arc covered by the new-seat bins (same as MIN/MAX_PULSE_US) */
+#define TRACK_MIN_US     1000u
+#define TRACK_MAX_US     2500u
+#define NEW_BIN_US       50u
+#define NEW_MARGIN_US    50u
+#define NEW_SEAT_HITS    3u
+
+#define NEW_BINS         ((TRACK_MAX_US - TRACK_MIN_US) / NEW_BIN_US + 1u)
+
+/* ????????? Module State ????????? */
+static uint16_t loUs[TRACK_MAX], hiUs[TRACK_MAX];
+static uint8_t  presence[TRACK_MAX];
+static uint8_t  nSeats = 0;
+static uint8_t  active = 0;
+static uint8_t  newHits[NEW_BINS];
+
+void SeatTrack_Begin(const uint16_t *angleUs, const uint16_t *widthUs, uint8_t n) {
+    nSeats = (n < TRACK_MAX) ? n : TRACK_MAX;
+    for (uint8_t i = 0; i < nSeats; i++) {
+        loUs[i] = angleUs[i] - widthUs[i] / 2;
+        hiUs[i] = loUs[i] + widthUs[i];
+        presence[i] = 100;
+    }
+    for (uint8_t b = 0; b < NEW_BINS; b++) {
+        newHits[b] = 0;
+    }
+    active = 1;
+}
+
+void SeatTrack_End(void) {
+    active = 0;
+}
+
+uint8_t SeatTrack_IsActive(void) {
+    return active;
+}
+
+uint16_t SeatTrack_AddSample(uint16_t pulseUs, uint8_t hit, uint8_t settled) {
+    uint8_t clear = 1;      /* 1 if well away from every known seat */
+
+    for (uint8_t i = 0; i < nSeats; i++) {
+        if (pulseUs >= loUs[i] && pulseUs <= hiUs[i] && settled) {
+            if (hit) {
+                presence[i] = (presence[i] > 100 - PRES_UP) ? 100 : presence[i] + PRES_UP;
+            } else {
+                presence[i] = (presence[i] < PRES_DOWN) ? 0 : presence[i] - PRES_DOWN;
+            }
+        }
+        if (pulseUs + NEW_MARGIN_US >= loUs[i] && pulseUs <= hiUs[i] + NEW_MARGIN_US) {
+            clear = 0;
+        }
+    }
+    if (!clear || pulseUs < TRACK_MIN_US || pulseUs > TRACK_MAX_US) {
+        return 0;
+    }
+
+    uint8_t b = (pulseUs - TRACK_MIN_US) / NEW_BIN_US;
+    if (!hit) {
+        if (newHits[b] && newHits[b] < NEW_SEAT_HITS) {
+            newHits[b]--;
+        }
+        return 0;
+    }
+    if (newHits[b] < NEW_SEAT_HITS && ++newHits[b] == NEW_SEAT_HITS) {
+        return TRACK_MIN_US + b * NEW_BIN_US + NEW_BIN_US / 2;
+    }
+    return 0;
+}
+
+uint8_t SeatTrack_Presence(uint8_t i) {
+    return presence[i];
+}
+
+uint8_t SeatTrack_IsPresent(uint8_t i) {
+    return presence[i] >= PRES_MIN;
+}
+
+/* ????????? Offline simulation ????????? */
+/*
+ * Build on a PC:  gcc -O2 -DSEAT_TRACK_TEST -o seattrack SeatTrack.c
+ * Run:            ./seattrack [trials]
+ *
+ * Simulates seek-mode dealing of 7 cards (Go Fish) to four seats with
+ * sonar readings every SIM_PERIOD_MS. SIM_STOP_SAMPLES settled readings
+ * are taken at each stop and readings are taken at SIM_US_PER_MS while
+ * moving; each reading is wrong with probability SIM_ERR.
+ * Seat SIM_LEAVER leaves after round SIM_LEAVE_ROUND, and a new player sits
+ * down at SIM_JOIN_US after round SIM_JOIN_ROUND. The simulation prints,
+ * averaged over the trials:
+ *   - deals to an empty seat without tracking,
+ *   - deals to an empty seat with tracking,
+ *   - deals wrongly skipped at an occupied seat,
+ *   - the round in which the new player was flagged (0 = never).
+ */
+#ifdef SEAT_TRACK_TEST
+#include <stdio.h>
+#include <stdlib.h>
+
+#define SIM_SEATS        4
+#define SIM_CARDS        7
+#define SIM_WIDTH_US     200u
+#define SIM_PERIOD_MS    60u
+#define SIM_US_PER_MS    3.2f
+#define SIM_STOP_SAMPLES 2
+#define SIM_ERR          0.05
+#define SIM_LEAVER       1
+#define SIM_LEAVE_ROUND  2
+#define SIM_JOIN_US      1800u
+#define SIM_JOIN_ROUND   1
+
+static const uint16_t simAngle[SIM_SEATS] = {1200, 1600, 2000, 2400};
+static const uint16_t simWidth[SIM_SEATS] = {SIM_WIDTH_US, SIM_WIDTH_US,
+                                             SIM_WIDTH_US, SIM_WIDTH_US};
+
+static uint8_t Truth(uint16_t p, const uint8_t *occ, uint8_t joined) {
+    for (int i = 0; i < SIM_SEATS; i++) {
+        if (occ[i] && p + SIM_WIDTH_US / 2 >= simAngle[i] && p <= simAngle[i] + SIM_WIDTH_US / 2) {
+            return 1;
+        }
+    }
+    return joined && p + SIM_WIDTH_US / 2 >= SIM_JOIN_US && p <= SIM_JOIN_US + SIM_WIDTH_US / 2;
+}
+
+static uint8_t Sense(uint16_t p, const uint8_t *occ, uint8_t joined) {
+    uint8_t t = Truth(p, occ, joined);
+    return (rand() < SIM_ERR * RAND_MAX) ? !t : t;
+}
+
+int main(int argc, char **argv) {
+    int trials = (argc > 1) ? atoi(argv[1]) : 1000;
+    long wastedOff = 0, wastedOn = 0, falseSkip = 0, flaggedSum = 0, flaggedN = 0;
+    srand(1);
+
+    for (int tr = 0; tr < trials; tr++) {
+        uint8_t occ[SIM_SEATS] = {1, 1, 1, 1};
+        uint8_t remain[SIM_SEATS];
+        uint8_t joined = 0;
+        int flaggedRound = 0;
+        float pos = simAngle[0];
+        float phase = (float)(rand() % SIM_PERIOD_MS);
+
+        for (int i = 0; i < SIM_SEATS; i++) {
+            remain[i] = SIM_CARDS;
+        }
+        SeatTrack_Begin(simAngle, simWidth, SIM_SEATS);
+
+        for (int round = 0; round < SIM_CARDS; round++) {
+            if (round == SIM_LEAVE_ROUND) occ[SIM_LEAVER] = 0;
+            if (round == SIM_JOIN_ROUND)  joined = 1;
+
+            for (int i = 0; i < SIM_SEATS; i++) {
+                if (!remain[i]) continue;
+                /* move to the seat, reading the sonar on the way */
+                float dist = simAngle[i] - pos;
+                float t = phase, T = (dist < 0 ? -dist : dist) / SIM_US_PER_MS;
+                for (; t < T; t += SIM_PERIOD_MS) {
+                    uint16_t p = (uint16_t)(pos + dist * t / T);
+                    if (SeatTrack_AddSample(p, Sense(p, occ, joined), 0) && !flaggedRound) {
+                        flaggedRound = round + 1;
+                    }
+                }
+                phase = t - T;
+                pos = simAngle[i];
+                /* settled readings at the seat */
+                for (int k = 0; k < SIM_STOP_SAMPLES; k++) {
+                    SeatTrack_AddSample(simAngle[i], Sense(simAngle[i], occ, joined), 1);
+                }
+                /* deal, or skip an empty seat */
+                if (SeatTrack_IsPresent(i)) {
+                    wastedOn += !occ[i];
+                    remain[i]--;
+                } else {
+                    falseSkip += occ[i];
+                    remain[i] = 0;
+                }
+            }
+        }
+        /* without tracking the leaver gets every card from SIM_LEAVE_ROUND on */
+        wastedOff += SIM_CARDS - SIM_LEAVE_ROUND;
+        if (flaggedRound) {
+            flaggedSum += flaggedRound;
+            flaggedN++;
+        }
+    }
+
+    printf("trials=%d\r\n", trials);
+    printf("wasted deals without tracking: %.2f\r\n", (double)wastedOff / trials);
+    printf("wasted deals with tracking:    %.2f\r\n", (double)wastedOn / trials);
+    printf("occupied seats skipped:        %.3f\r\n", (double)falseSkip / trials);
+    printf("new player flagged in %.0f%% of trials, mean round %.2f\r\n",
+           100.0 * flaggedN / trials, flaggedN ? (double)flaggedSum / flaggedN : 0.0);
+    return 0;
+}
+#endif  /* SEAT_TRACK_TEST */
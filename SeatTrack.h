@@ -0,0 +1,44 @@
+/* SeatTrack.h */
+
+#ifndef SEAT_TRACK_H
+#define SEAT_TRACK_H
+
+#include <stdint.h>
+
+/* Most seats tracked at once */
+#define TRACK_MAX    10
+
+/**
+ * @brief   Start tracking n seats (centre and width in us of pulse width, as
+ *          calibrated). Every seat starts out fully present.
+ */
+void     SeatTrack_Begin(const uint16_t *angleUs, const uint16_t *widthUs, uint8_t n);
+
+/**
+ * @brief   Stop tracking; SeatTrack_IsActive() returns 0 until the next Begin.
+ */
+void     SeatTrack_End(void);
+
+uint8_t  SeatTrack_IsActive(void);
+
+/**
+ * @brief   Feed one sonar reading taken during the hand.
+ *          'settled' is 1 if the servo was at rest at pulseUs. Only settled
+ *          readings inside a seat's extent update that seat's presence;
+ *          readings well clear of every seat count toward a new seat there.
+ * @return  Centre (us) of a newly occupied spot the first time it is
+ *          confirmed, else 0.
+ */
+uint16_t SeatTrack_AddSample(uint16_t pulseUs, uint8_t hit, uint8_t settled);
+
+/**
+ * @brief   Presence confidence of seat i, 0..100.
+ */
+uint8_t  SeatTrack_Presence(uint8_t i);
+
+/**
+ * @brief   Returns 1 while seat i is still believed to be occupied.
+ */
+uint8_t  SeatTrack_IsPresent(uint8_t i);
+
+#endif  /* SEAT_TRACK_H */
@@ -3,17 +3,31 @@
 #include "ES_Events.h"
 #include "ES_Timers.h"
 #include "HCSR04.h"
+#include "Baseline.h"
+#include "SeatTrack.h"
+#include "ServoMotion.h"
+#include "ADWindow.h"
 #include <stdint.h>
 
 #define PLAYER_DETECT_CM   30
 #define NEAR_CM            (PLAYER_DETECT_CM      )   // 45
 #define FAR_CM             (PLAYER_DETECT_CM + 10)     // 49
-#define STALL_TIMEOUT_MS 200
+#define STALL_TIMEOUT_MS 60     /* no encoder edge for this long = stalled */
+#define STALL_GRACE_MS   80     /* extra time for the first edge after a start */
 
 /* ????? distance checker enable flag ????? */
 static uint8_t detectEnabled = 1;
 void Distance_Enable(uint8_t en) { detectEnabled = en; }
 
+/* ????? near test shared with callers that sample the range themselves ????? */
+uint8_t Distance_IsNear(uint16_t cm) { return cm >= NEAR_CM; }
+
+/* ????? seat test: background subtraction once a baseline exists ????? */
+uint8_t Distance_IsSeatHit(uint16_t pulseUs, uint16_t cm)
+{
+    return Baseline_IsValid() ? Baseline_IsHit(pulseUs, cm) : Distance_IsNear(cm);
+}
+
 /* ????? DISTANCE checker (never clears newFlag) ????? */
 uint8_t CheckDistance(void)
 {
@@ -22,7 +36,7 @@ uint8_t CheckDistance(void)
     static uint8_t last = 0xFF;        /* 0 near, 1 mid, 2 far */
     uint16_t cm = HCSR04_GetDistanceCm();
 
-    uint8_t now = (cm >= NEAR_CM) ? 0 : (cm <= FAR_CM) ? 2 : 1;
+    uint8_t now = Distance_IsNear(cm) ? 0 : (cm <= FAR_CM) ? 2 : 1;
     if (now != last) {
         ES_Event e;
         if (now == 0)      e.EventType = DIST_NEAR;
@@ -40,14 +54,54 @@ uint8_t CheckDistance(void)
     return 0;
 }
 
-/* ????? MOTOR stall checker (unchanged) ????? */
-static uint32_t lastPulse = 0; static uint8_t stalled = 0;
-void Motor_EncoderPulse(void) { lastPulse = ES_Timer_GetTime(); }
+/* ????? SEAT tracking checker (active while dealing) ????? */
+uint8_t CheckSeatTrack(void)
+{
+    if (!SeatTrack_IsActive() || !HCSR04_NewReadingAvailable()) return 0;
+
+    uint16_t p  = ServoMotion_GetPulse();
+    uint16_t cm = HCSR04_GetDistanceCm();
+    uint16_t joined = SeatTrack_AddSample(p, Distance_IsSeatHit(p, cm),
+                                          !ServoMotion_IsBusy());
+    if (joined) {
+        ES_Event e = { .EventType = SEAT_JOINED, .EventParam = joined };
+        ES_PostAll(e);
+        return 1;
+    }
+    return 0;
+}
+
+/* ????? A/D window checker (crossings latched by the A/D ISR, see AD_SetWindow) ????? */
+uint8_t CheckADWindow(void)
+{
+    uint16_t p;
+    if (!ADWindow_Next(ES_Timer_GetTime(), &p)) return 0;
+
+    ES_Event e = { .EventType = AD_WINDOW, .EventParam = p };
+    ES_PostAll(e);
+    return 1;
+}
+
+/* ????? MOTOR stall checker (pulses come from the Encoder ISR) ????? */
+static volatile uint32_t lastPulse = 0; static uint8_t stalled = 0;
+static volatile uint8_t edgeSeen = 0; static uint8_t stallArmed = 0;
+void Motor_EncoderPulse(void) { lastPulse = ES_Timer_GetTime(); edgeSeen = 1; }
+uint32_t Motor_LastPulseMs(void) { return lastPulse; }
+
+/* only a motor that has been told to turn can stall; arming restarts the clock */
+void Motor_ArmStall(uint8_t on)
+{
+    stallArmed = on;
+    lastPulse = ES_Timer_GetTime(); edgeSeen = 0; stalled = 0;
+}
 
 uint8_t CheckMotor(void)
 {
+    if (!stallArmed) return 0;
+
     uint32_t now = ES_Timer_GetTime(); ES_Event e;
-    if (!stalled && (now - lastPulse) > STALL_TIMEOUT_MS) {
+    uint32_t limit = STALL_TIMEOUT_MS + (edgeSeen ? 0 : STALL_GRACE_MS);
+    if (!stalled && (now - lastPulse) > limit) {
         e.EventType = MOTOR_STALLED; e.EventParam = 0; ES_PostAll(e);
         stalled = 1; return 1;
     }
@@ -6,8 +6,26 @@
 /* called by ES_Framework each pass */
 uint8_t CheckDistance(void);
 uint8_t CheckMotor(void);
+uint8_t CheckSeatTrack(void);
+uint8_t CheckADWindow(void);
+
+/* timestamp one roller encoder edge (called from the Encoder ISR) */
+void    Motor_EncoderPulse(void);
+
+/* ES_Timer time (ms) of the last roller encoder edge */
+uint32_t Motor_LastPulseMs(void);
+
+/* 1 = motor commanded to turn, watch for MOTOR_STALLED; 0 = motor off */
+void    Motor_ArmStall(uint8_t on);
 
 /* NEW: turn distance checker on/off (1=enabled,0=disabled) */
 void    Distance_Enable(uint8_t enable);
 
+/* 1 if a range reading counts as "someone there" (same test as DIST_NEAR) */
+uint8_t Distance_IsNear(uint16_t cm);
+
+/* 1 if a range taken at pulseUs counts as a seated player: departs from the
+   empty-table baseline if one was recorded, else the Distance_IsNear() test */
+uint8_t Distance_IsSeatHit(uint16_t pulseUs, uint16_t cm);
+
 #endif  /* SENSOR_MOTOR_EVENT_CHECKER_H */
@@ -0,0 +1,236 @@
+/* =============================================================================
+ * File:    ServoMotion.c
+ * Purpose: Profiled servo moves and a settle-time model on top of RC_Servo.
+ *
+ * Dependencies:
+ *   - RC_Servo.h      - RC_SetPulseTime() / RC_GetPulseTime()
+ *   - ES_Timers.h     - millisecond time base for the profiles
+ *   - ES_Framework.h  - ES_PostAll() for SERVO_SETTLED
+ *
+ * Behavior:
+ *   - A move is a position profile p(t) from the current commanded pulse to
+ *     the target. CheckServoMotion() evaluates p(t) each pass and writes it
+ *     with RC_SetPulseTime() whenever the integer pulse changes.
+ *   - The horn lags the command: it cannot exceed SERVO_US_PER_MS and needs
+ *     SERVO_ACCEL_MS to get up to speed, then rings for a time that grows
+ *     with the distance moved. The move is reported settled at
+ *         start + max(profile time, servo travel time) + ringing time.
+ *   - The model constants below are for the dealer's standard servo with the
+ *     card shoe loaded; re-fit them if the servo or the load changes.
+ *   - With ServoMotion_UseBatComp(1) both speeds (servo and profile) scale
+ *     with BatComp_SpeedScale(), for a servo fed straight from the pack.
+ *     A move keeps the profile speed it started with.
+ * =============================================================================
+ */
+#include <stdint.h>
+#include <math.h>
+#include "ServoMotion.h"
+#include "RC_Servo.h"
+#include "ES_Timers.h"
+#include "ES_Framework.h"
+#include "BatComp.h"
+
+/* ????????? Servo model (calibrated) ????????? */
+/* Top slew rate of the loaded servo, in us of pulse width per ms */
+#define SERVO_US_PER_MS     4.0f
+/* Time the servo needs to get from rest up to SERVO_US_PER_MS */
+#define SERVO_ACCEL_MS      40.0f
+/* Ringing after the horn arrives: fixed part plus a part per 100 us moved */
+#define RING_BASE_MS        30u
+#define RING_PER_100US_MS   6u
+
+/* ????????? Commanded profiles ????????? */
+/* Cruise speed and ramp time used for SM_TRAPEZOID and SM_SCURVE moves */
+#define PROFILE_US_PER_MS   3.2f
+#define PROFILE_ACCEL_MS    80.0f
+
+static unsigned short int ServoPin;
+static ServoProfile_t Profile;
+static uint16_t startUs, targetUs, lastCmdUs;
+static uint32_t startMs;
+static uint16_t profileMs;      /* duration of the commanded profile */
+static uint16_t settleMs;       /* start -> settled, per the model */
+static uint16_t lastWaitMs;
+static uint8_t  moving = 0;     /* 1 while the setpoint is still changing */
+static uint8_t  settling = 0;   /* 1 until SERVO_SETTLED has been posted */
+static uint8_t  batComp = 0;    /* 1 = speeds follow the battery */
+static float    profileV = PROFILE_US_PER_MS;  /* cruise speed of this move */
+
+/* SpeedScale: servo speed now relative to the calibrated model */
+static float SpeedScale(void) {
+    return batComp ? (float)BatComp_SpeedScale() / BATCOMP_ONE : 1.0f;
+}
+
+/**
+ * TrapDuration(d, v, ta)
+ *   Duration (ms) of a trapezoidal move of d us with cruise speed v us/ms and
+ *   ramp time ta ms. Short moves never reach v and become a triangle.
+ */
+static float TrapDuration(float d, float v, float ta) {
+    float a = v / ta;
+    if (d <= v * ta) {
+        /* triangle: accelerate for half the distance, brake for the rest */
+        return 2.0f * sqrtf(d / a);
+    }
+    return d / v + ta;
+}
+
+/**
+ * TrapPosition(t, d, v, ta, T)
+ *   Distance (us) covered at time t of a trapezoidal move lasting T ms.
+ */
+static float TrapPosition(float t, float d, float v, float ta, float T) {
+    float a = v / ta;
+    float th = T / 2.0f;
+    if (d <= v * ta) {
+        return (t < th) ? 0.5f * a * t * t
+                        : d - 0.5f * a * (T - t) * (T - t);
+    }
+    if (t < ta) {
+        return 0.5f * a * t * t;
+    }
+    if (t < T - ta) {
+        return 0.5f * v * ta + v * (t - ta);
+    }
+    return d - 0.5f * a * (T - t) * (T - t);
+}
+
+/* TravelMs: time for the horn to cover distUs at its own speed limit */
+static uint16_t TravelMs(uint16_t distUs) {
+    return (uint16_t)(TrapDuration(distUs, SERVO_US_PER_MS * SpeedScale(),
+                                   SERVO_ACCEL_MS) + 0.5f);
+}
+
+/* RingMs: time the horn keeps ringing after it arrives */
+static uint16_t RingMs(uint16_t distUs) {
+    if (distUs == 0) {
+        return 0;
+    }
+    return RING_BASE_MS + (uint16_t)(((uint32_t)distUs * RING_PER_100US_MS) / 100u);
+}
+
+/**
+ * ServoMotion_SettleMs(distUs)
+ *   Step-response model of the loaded servo: travel at its own speed limit
+ *   plus ringing proportional to the size of the step.
+ */
+uint16_t ServoMotion_SettleMs(uint16_t distUs) {
+    return TravelMs(distUs) + RingMs(distUs);
+}
+
+/* ProfileMs: duration of the commanded profile for a move of distUs */
+static uint16_t ProfileMs(uint16_t distUs, ServoProfile_t profile) {
+    float T = 0.0f;
+    float v = PROFILE_US_PER_MS * SpeedScale();
+    if (profile == SM_TRAPEZOID) {
+        T = TrapDuration(distUs, v, PROFILE_ACCEL_MS);
+    } else if (profile == SM_SCURVE) {
+        /* smoothstep peaks at 1.5x its mean speed; keep that at cruise speed */
+        T = 1.5f * distUs / v;
+    }
+    return (uint16_t)(T + 0.5f);
+}
+
+/**
+ * ServoMotion_MoveMs(distUs, profile)
+ *   The servo cannot beat its own travel time; a slower profile lets it
+ *   track closely, leaving only the ringing once the setpoint arrives.
+ */
+uint16_t ServoMotion_MoveMs(uint16_t distUs, ServoProfile_t profile) {
+    uint16_t p  = ProfileMs(distUs, profile);
+    uint16_t tr = TravelMs(distUs);
+    return ((p > tr) ? p : tr) + RingMs(distUs);
+}
+
+/**
+ * ServoMotion_Init(rcPin)
+ *   Remembers the pin and adopts its current pulse as the resting position.
+ */
+void ServoMotion_Init(unsigned short int rcPin) {
+    ServoPin  = rcPin;
+    lastCmdUs = targetUs = startUs = (uint16_t)RC_GetPulseTime(rcPin);
+    moving = settling = 0;
+}
+
+/**
+ * ServoMotion_MoveTo(target, profile)
+ *   Plans the move and predicts when the horn will be settled.
+ */
+void ServoMotion_MoveTo(uint16_t target, ServoProfile_t profile) {
+    uint16_t d;
+
+    /* start from the live command; callers may also drive RC_SetPulseTime() */
+    startUs  = lastCmdUs = (uint16_t)RC_GetPulseTime(ServoPin);
+    targetUs = target;
+    Profile  = profile;
+    startMs  = ES_Timer_GetTime();
+    d = (target > startUs) ? target - startUs : startUs - target;
+
+    profileV   = PROFILE_US_PER_MS * SpeedScale();
+    profileMs  = ProfileMs(d, profile);
+    settleMs   = ServoMotion_MoveMs(d, profile);
+    lastWaitMs = settleMs - profileMs;
+
+    moving = settling = 1;
+    CheckServoMotion();         /* issue the first setpoint right away */
+}
+
+void ServoMotion_UseBatComp(uint8_t on) {
+    batComp = on;
+}
+
+uint8_t ServoMotion_IsBusy(void) {
+    return settling;
+}
+
+uint16_t ServoMotion_LastWaitMs(void) {
+    return lastWaitMs;
+}
+
+uint16_t ServoMotion_GetPulse(void) {
+    return (uint16_t)RC_GetPulseTime(ServoPin);
+}
+
+/**
+ * CheckServoMotion()
+ *   Called by ES_CheckEvents each pass.
+ *   Updates the setpoint along the profile and posts SERVO_SETTLED once the
+ *   model's settle time has elapsed.
+ */
+uint8_t CheckServoMotion(void) {
+    if (!settling) {
+        return 0;
+    }
+    uint32_t t = ES_Timer_GetTime() - startMs;
+
+    if (moving) {
+        uint16_t cmd = targetUs;
+        if (t < profileMs) {
+            float d = (targetUs > startUs) ? targetUs - startUs : startUs - targetUs;
+            float p;
+            if (Profile == SM_SCURVE) {
+                float u = (float)t / profileMs;
+                p = d * u * u * (3.0f - 2.0f * u);
+            } else {
+                p = TrapPosition(t, d, profileV, PROFILE_ACCEL_MS, profileMs);
+            }
+            cmd = (targetUs > startUs) ? startUs + (uint16_t)p
+                                       : startUs - (uint16_t)p;
+        } else {
+            moving = 0;
+        }
+        if (cmd != lastCmdUs) {
+            lastCmdUs = cmd;
+            RC_SetPulseTime(ServoPin, cmd);
+        }
+    }
+
+    if (!moving && t >= settleMs) {
+        settling = 0;
+        ES_Event e = { .EventType = SERVO_SETTLED,
+                       .EventParam = targetUs };
+        ES_PostAll(e);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,73 @@
+/* ServoMotion.h */
+
+#ifndef SERVO_MOTION_H
+#define SERVO_MOTION_H
+
+#include <stdint.h>
+#include "ES_Events.h"
+
+typedef enum {
+    SM_STEP      = 0,   /* command the target at once, servo slews at its own max */
+    SM_TRAPEZOID = 1,   /* constant-acceleration ramp, cruise, ramp down */
+    SM_SCURVE    = 2    /* smoothstep position profile, zero jerk at both ends */
+} ServoProfile_t;
+
+/**
+ * @brief   Attach the motion layer to an RC servo pin that has already been
+ *          added with RC_AddPins(). Must be called once before any move.
+ */
+void        ServoMotion_Init(unsigned short int rcPin);
+
+/**
+ * @brief   Start a move from the currently commanded pulse to targetUs using
+ *          the given profile. Any move in progress is replaced; the new one
+ *          starts from wherever the old setpoint had got to.
+ *          SERVO_SETTLED is posted once the model says the horn has stopped.
+ */
+void        ServoMotion_MoveTo(uint16_t targetUs, ServoProfile_t profile);
+
+/**
+ * @brief   1 = the servo runs straight off the pack: its speed model and the
+ *          profile speeds scale with BatComp_SpeedScale(). 0 (default) = the
+ *          calibrated speeds, for a servo on its own regulated supply.
+ */
+void        ServoMotion_UseBatComp(uint8_t on);
+
+/**
+ * @brief   Returns 1 while a move is running or the servo is still settling.
+ */
+uint8_t     ServoMotion_IsBusy(void);
+
+/**
+ * @brief   Settle-time model: milliseconds from the moment a step of distUs is
+ *          commanded until the horn has stopped moving (travel + ringing).
+ */
+uint16_t    ServoMotion_SettleMs(uint16_t distUs);
+
+/**
+ * @brief   Same model for a profiled move: milliseconds from ServoMotion_MoveTo()
+ *          over distUs with the given profile until SERVO_SETTLED.
+ */
+uint16_t    ServoMotion_MoveMs(uint16_t distUs, ServoProfile_t profile);
+
+/**
+ * @brief   Milliseconds between the end of the last profile (setpoint reached)
+ *          and the predicted settle point, i.e. how long the caller still had
+ *          to wait once the commanded pulse arrived.
+ */
+uint16_t    ServoMotion_LastWaitMs(void);
+
+/**
+ * @brief   Pulse width currently commanded on the servo pin, whether it was
+ *          set by a profile or directly with RC_SetPulseTime().
+ */
+uint16_t    ServoMotion_GetPulse(void);
+
+/**
+ * @brief   Event-checker for the motion layer.
+ *          Advances the active profile through RC_SetPulseTime() and posts
+ *          SERVO_SETTLED (EventParam = target pulse) when the move is done.
+ */
+uint8_t     CheckServoMotion(void);
+
+#endif  /* SERVO_MOTION_H */
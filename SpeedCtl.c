@@ -0,0 +1,265 @@
+/* =============================================================================
+ * File:    SpeedCtl.c
+ * Purpose: Hold the feed roller at a set speed, so the throw doesn't change
+ *          with the battery voltage and the roller wear.
+ *
+ * Dependencies:
+ *   - none; FeedMotor.c steps it from the PWM period hook
+ *   - test build: RampShape.c - the open-loop ramp it is compared against
+ *
+ * Behavior:
+ *   - PID on roller speed in encoder counts per second, stepped every
+ *     SPEED_PERIOD_MS by FeedMotor.c from the PWM timer interrupt.
+ *   - Each deal phase (eject, tuck, nudge) has its own setpoint; gains and
+ *     setpoints can be changed at run time.
+ *   - The derivative acts on the measured speed, not on the error, so a new
+ *     setpoint doesn't kick the output.
+ *   - Anti-windup: the integral is only kept when it doesn't push the output
+ *     further past 0 or SPEED_DUTY_MAX, so a stall or a flat battery doesn't
+ *     leave it wound up for the next move.
+ *   - The first step after SpeedCtl_Start() backs the proportional term out
+ *     of the integral, so the output carries on from the start duty.
+ * =============================================================================
+ */
+#include <stdint.h>
+#include "SpeedCtl.h"
+
+/* ????????? Tunables ????????? */
+/* Setpoints (encoder counts/s). Eject is just below the slowest roller
+   speed at full duty on a critical (8.5 V) pack, so there is headroom left
+   to regulate with, and the slowest fling still ends well inside the
+   MOTOR_FWD_MS encoder timeout (see the simulation below) */
+#define SPEED_EJECT_CPS  95u
+#define SPEED_TUCK_CPS   50u
+#define SPEED_NUDGE_CPS  40u
+/* Gains x256 (see SpeedGains_t) */
+#define SPEED_KP         1024u
+#define SPEED_KI         256u
+#define SPEED_KD         0u
+#define SPEED_DUTY_MAX   1000u      /* MAX_PWM */
+
+/* ????????? Module State ????????? */
+static SpeedGains_t gains;
+static uint16_t     setpoint[SPEED_PHASES];
+static SpeedPhase_t phase = SPEED_EJECT;
+static int32_t      integ = 0;      /* x256 duty */
+static uint16_t     prevCps = 0;
+static uint16_t     out = 0;
+static uint8_t      first = 1;
+
+void SpeedCtl_Init(void) {
+    gains.kp = SPEED_KP;
+    gains.ki = SPEED_KI;
+    gains.kd = SPEED_KD;
+    setpoint[SPEED_EJECT] = SPEED_EJECT_CPS;
+    setpoint[SPEED_TUCK]  = SPEED_TUCK_CPS;
+    setpoint[SPEED_NUDGE] = SPEED_NUDGE_CPS;
+}
+
+void SpeedCtl_SetGains(const SpeedGains_t *g) {
+    gains.kp = g->kp;
+    gains.ki = g->ki;
+    gains.kd = g->kd;
+}
+
+const SpeedGains_t *SpeedCtl_Gains(void) {
+    return &gains;
+}
+
+void SpeedCtl_SetSetpoint(SpeedPhase_t p, uint16_t cps) {
+    if (p < SPEED_PHASES) {
+        setpoint[p] = cps;
+    }
+}
+
+uint16_t SpeedCtl_Setpoint(SpeedPhase_t p) {
+    return (p < SPEED_PHASES) ? setpoint[p] : 0;
+}
+
+void SpeedCtl_Start(SpeedPhase_t p, uint16_t duty) {
+    phase = (p < SPEED_PHASES) ? p : SPEED_EJECT;
+    out   = (duty > SPEED_DUTY_MAX) ? SPEED_DUTY_MAX : duty;
+    integ = (int32_t)out << 8;
+    first = 1;
+}
+
+uint16_t SpeedCtl_Step(uint16_t cps) {
+    int32_t e = (int32_t)setpoint[phase] - (int32_t)cps;
+    int32_t p = (int32_t)gains.kp * e;
+    int32_t d = first ? 0 : -(int32_t)gains.kd * ((int32_t)cps - (int32_t)prevCps);
+    prevCps = cps;
+    if (first) {
+        integ = ((int32_t)out << 8) - p;
+        first = 0;
+    }
+    int32_t i = integ + (int32_t)gains.ki * e;
+    int32_t u = (i + p + d) / 256;
+
+    if (u > (int32_t)SPEED_DUTY_MAX) {
+        u = SPEED_DUTY_MAX;
+        if (e < 0) integ = i;
+    } else if (u < 0) {
+        u = 0;
+        if (e > 0) integ = i;
+    } else {
+        integ = i;
+    }
+    /* the integral alone never needs to leave the output range */
+    if (integ < 0) {
+        integ = 0;
+    } else if (integ > ((int32_t)SPEED_DUTY_MAX << 8)) {
+        integ = (int32_t)SPEED_DUTY_MAX << 8;
+    }
+    out = (uint16_t)u;
+    return out;
+}
+
+uint16_t SpeedCtl_Duty(void) {
+    return out;
+}
+
+/* ????????? Offline simulation ????????? */
+/*
+ * Build on a PC:  gcc -O2 -DSPEED_CTL_TEST -o speedctl SpeedCtl.c RampShape.c -lm
+ * Run:            ./speedctl
+ *
+ * Flings SIM_CARDS cards with the motor and battery model of RampShape.c's
+ * simulation (same constants: 0.1 ms Euler steps, duty updated once per
+ * 1 ms PWM period, cell voltage SIM_V_LO..SIM_V_HI, card drag
+ * SIM_LOAD +- SIM_LOAD_VAR), started with the 40 ms Ramp_Exp soft start:
+ *   - open loop: duty stays at 1000 after the ramp, as now;
+ *   - closed loop: after the ramp SpeedCtl holds SPEED_EJECT_CPS, stepped
+ *     every SPEED_PERIOD_MS on the speed the encoder would report.
+ * The encoder gives SIM_CPR edges per roller radian (24 edges over the
+ * 60 mm exit, as EJECT_COUNTS). The speed is measured the way
+ * Encoder_GetSpeed() does it: 1 / time between the last two edges, or
+ * 1 / time since the last edge once that is longer, in 1.6 us Timer3 ticks.
+ * The cell voltage spans the 3S LiFePO4 pack BatMonitor grades, 8.5 V
+ * (critical) to 10.8 V (full).
+ * Prints, for each battery band and overall: mean and longest time to exit,
+ * mean exit speed, and the coefficient of variation of the throw (exit
+ * speed squared) across the cards. Every constant is an assumption, not a
+ * measurement.
+ */
+#ifdef SPEED_CTL_TEST
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "RampShape.h"
+
+#define SIM_CARDS     4000
+#define SIM_DT        1e-4
+#define SIM_PWM_S     1e-3
+#define SIM_V_LO      8.5
+#define SIM_V_HI      10.8
+#define SIM_RBAT      0.35
+#define SIM_R         3.0
+#define SIM_K         0.30
+#define SIM_J         8e-4
+#define SIM_B         2e-3
+#define SIM_LOAD      0.15
+#define SIM_LOAD_VAR  0.25
+#define SIM_RADIUS    0.012
+#define SIM_EXIT_MM   60.0
+#define SIM_RAMP_MS   40u
+#define SIM_CPR       (24.0 / (SIM_EXIT_MM / 1000.0 / SIM_RADIUS))
+#define SIM_TICK_HZ   625000.0      /* Timer3: 40 MHz / 64 */
+#define SIM_STALE_S   0.080
+
+typedef struct {
+    double exitMs, cps, dist;
+} Fling_t;
+
+static double Uniform(double lo, double hi) {
+    return lo + (hi - lo) * rand() / (double)RAND_MAX;
+}
+
+/* Speed as Encoder_GetSpeed() would report it at time t */
+static uint16_t EncoderCps(double t, double lastEdge, double period) {
+    if (period <= 0 || t - lastEdge >= SIM_STALE_S) {
+        return 0;
+    }
+    uint32_t per = (uint32_t)(period * SIM_TICK_HZ);
+    uint32_t age = (uint32_t)((t - lastEdge) * SIM_TICK_HZ);
+    if (age > per) per = age;
+    return per ? (uint16_t)(SIM_TICK_HZ / per) : 0;
+}
+
+static Fling_t Fling(uint8_t closed, double cell, double load) {
+    Fling_t r = {0, 0, 0};
+    double w = 0, theta = 0, t = 0, duty = 0;
+    double exitRad = SIM_EXIT_MM / 1000.0 / SIM_RADIUS;
+    double nextEdge = 1.0 / SIM_CPR, lastEdge = -1, period = 0;
+    double nextTick = 0;
+    uint32_t tick = 0;
+    uint8_t regulating = 0;
+
+    while (theta < exitRad && t < 2.0) {
+        if (t >= nextTick) {
+            if (tick < SIM_RAMP_MS) {
+                duty = Ramp_At(&Ramp_Exp, 0, 1000, tick, SIM_RAMP_MS) / 1000.0;
+            } else if (!closed) {
+                duty = 1.0;
+            } else {
+                if (!regulating) {
+                    SpeedCtl_Start(SPEED_EJECT, (uint16_t)(duty * 1000.0 + 0.5));
+                    regulating = 1;
+                }
+                if ((tick - SIM_RAMP_MS) % SPEED_PERIOD_MS == 0) {
+                    duty = SpeedCtl_Step(EncoderCps(t, lastEdge, period)) / 1000.0;
+                }
+            }
+            tick++;
+            nextTick += SIM_PWM_S;
+        }
+        double i = (duty * cell - SIM_K * w) / (SIM_R + duty * SIM_RBAT);
+        if (i < 0) i = 0;
+        double torque = SIM_K * i - SIM_B * w - (w > 0 || SIM_K * i > load ? load : SIM_K * i);
+        w += torque / SIM_J * SIM_DT;
+        if (w < 0) w = 0;
+        theta += w * SIM_DT;
+        t += SIM_DT;
+        if (theta >= nextEdge) {
+            if (lastEdge >= 0) period = t - lastEdge;
+            lastEdge = t;
+            nextEdge += 1.0 / SIM_CPR;
+        }
+    }
+    r.exitMs = t * 1000.0;
+    r.cps = w * SIM_CPR;
+    r.dist = pow(w * SIM_RADIUS, 2);
+    return r;
+}
+
+static void Row(const char *name, uint8_t closed, double vLo, double vHi) {
+    double exitMs = 0, maxMs = 0, cps = 0, s = 0, s2 = 0;
+    srand(1);
+    for (int c = 0; c < SIM_CARDS; c++) {
+        double cell = Uniform(vLo, vHi);
+        double load = SIM_LOAD * Uniform(1.0 - SIM_LOAD_VAR, 1.0 + SIM_LOAD_VAR);
+        Fling_t f = Fling(closed, cell, load);
+        exitMs += f.exitMs;
+        if (f.exitMs > maxMs) maxMs = f.exitMs;
+        cps += f.cps;
+        s += f.dist;
+        s2 += f.dist * f.dist;
+    }
+    double mean = s / SIM_CARDS;
+    double cv = sqrt(s2 / SIM_CARDS - mean * mean) / mean;
+    printf("%-7s %4.1f-%4.1f  %8.1f  %8.1f  %8.1f  %8.1f%%\r\n", name, vLo, vHi,
+           exitMs / SIM_CARDS, maxMs, cps / SIM_CARDS, 100.0 * cv);
+}
+
+int main(void) {
+    static const double bands[][2] = {
+        {SIM_V_LO, 9.2}, {9.2, 10.0}, {10.0, SIM_V_HI}, {SIM_V_LO, SIM_V_HI}
+    };
+    SpeedCtl_Init();
+    printf("control battery_V  exit_ms   max_ms    exit_cps  throw_cv\r\n");
+    for (unsigned b = 0; b < sizeof bands / sizeof bands[0]; b++) {
+        Row("open", 0, bands[b][0], bands[b][1]);
+        Row("pid", 1, bands[b][0], bands[b][1]);
+    }
+    return 0;
+}
+#endif  /* SPEED_CTL_TEST */
@@ -0,0 +1,59 @@
+/* SpeedCtl.h */
+
+#ifndef SPEED_CTL_H
+#define SPEED_CTL_H
+
+#include <stdint.h>
+
+/* Control period (ms); SpeedCtl_Step() must be called at this rate */
+#define SPEED_PERIOD_MS  5u
+
+/* Phases of a deal, each with its own roller speed setpoint */
+typedef enum {
+    SPEED_EJECT,        /* fling a card out */
+    SPEED_TUCK,         /* lock the stack after a fling */
+    SPEED_NUDGE,        /* sweep-boundary / idle tuck */
+    SPEED_PHASES
+} SpeedPhase_t;
+
+/* PID gains, x256: duty (0..1000) per count/s of error. ki and kd are per
+   control period (integral gain * period, derivative gain / period) */
+typedef struct {
+    uint16_t kp;
+    uint16_t ki;
+    uint16_t kd;
+} SpeedGains_t;
+
+/**
+ * @brief   Load the compile-time gains and setpoints.
+ */
+void                SpeedCtl_Init(void);
+
+/**
+ * @brief   Change the gains or a setpoint (counts/s) at run time. Each value
+ *          is one 16-bit write, so it is safe while a move is running; the
+ *          next step picks it up.
+ */
+void                SpeedCtl_SetGains(const SpeedGains_t *g);
+const SpeedGains_t *SpeedCtl_Gains(void);
+void                SpeedCtl_SetSetpoint(SpeedPhase_t p, uint16_t cps);
+uint16_t            SpeedCtl_Setpoint(SpeedPhase_t p);
+
+/**
+ * @brief   Start holding phase p's setpoint. The output starts at 'duty'
+ *          (the duty the motor is already at), so the hand-over is bumpless.
+ */
+void                SpeedCtl_Start(SpeedPhase_t p, uint16_t duty);
+
+/**
+ * @brief   One control period: takes the measured roller speed (counts/s)
+ *          and returns the duty to apply, 0..MAX_PWM.
+ */
+uint16_t            SpeedCtl_Step(uint16_t cps);
+
+/**
+ * @brief   Duty returned by the last SpeedCtl_Step() (or set by Start).
+ */
+uint16_t            SpeedCtl_Duty(void);
+
+#endif  /* SPEED_CTL_H */
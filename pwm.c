@@ -6,6 +6,7 @@
  */
 
 #include <xc.h>
+#include <sys/attribs.h>
 #include <BOARD.h>
 
 #include <pwm.h>
@@ -33,6 +34,14 @@
 #define ALLPWMPINS (PWM_PORTZ06|PWM_PORTY12|PWM_PORTY10|PWM_PORTY04|PWM_PORTX11)
 #define NUM_PWM_CHANNELS 5
 
+#define RAMP_INT_PRIORITY 3
+
+/* Duty scale: register value = (Duty * DutyScale) >> DUTY_SHIFT, one 32x32
+ * multiply into 64 bits. With PR2 + 1 at most 2^16, a shift of 25 keeps
+ * DutyScale inside 32 bits and gives exactly ((PR2 + 1) * Duty) / MAX_PWM
+ * for every duty 0-1000 (checked on a PC for every PR2). */
+#define DUTY_SHIFT 25
+
 
 
 /*******************************************************************************
@@ -46,6 +55,51 @@ static volatile unsigned int * const Config_Registers[] = {&OC1CON, &OC2CON, &OC
 static unsigned int PWMActivePins;
 static unsigned int PWMFrequency;
 
+/* Ramp engine: channels (PWM_PORTxxx bits) with a ramp running, and each
+ * channel's ramp. DutyNow is the last duty written (0-1000). */
+static volatile unsigned int RampActive;
+static const RampProfile_t *RampProfile[NUM_PWM_CHANNELS];
+static unsigned short RampFrom[NUM_PWM_CHANNELS];
+static unsigned short RampTo[NUM_PWM_CHANNELS];
+static unsigned int RampTick[NUM_PWM_CHANNELS];
+static unsigned int RampTicks[NUM_PWM_CHANNELS];
+static volatile unsigned short DutyNow[NUM_PWM_CHANNELS];
+static unsigned int DutyScale;
+/* Called once per PWM period from the Timer2 interrupt, NULL = none */
+static void (* volatile PeriodHook)(void);
+
+/*******************************************************************************
+ * PRIVATE FUNCTIONS                                                           *
+ ******************************************************************************/
+
+static unsigned int ChannelIndex(unsigned char Channel)
+{
+    unsigned int TranslatedChannel = 0;
+    while (Channel > 1) {
+        Channel >>= 1;
+        TranslatedChannel++;
+    }
+    return TranslatedChannel;
+}
+
+static inline void WriteDuty(unsigned int Index, unsigned int Duty)
+{
+    *Duty_Registers[Index] = (unsigned int) (((unsigned long long) Duty * DutyScale) >> DUTY_SHIFT);
+    DutyNow[Index] = Duty;
+}
+
+/* Stops any ramp on Channel; the caller then owns its duty register */
+static void CancelRamp(unsigned char Channel)
+{
+    if (RampActive & Channel) {
+        IEC0CLR = _IEC0_T2IE_MASK;
+        RampActive &= ~Channel;
+        if (RampActive || PeriodHook) {
+            IEC0SET = _IEC0_T2IE_MASK;
+        }
+    }
+}
+
 /*******************************************************************************
  * PUBLIC FUNCTIONS                                                           *
  ******************************************************************************/
@@ -66,6 +120,11 @@ char PWM_Init(void)
     PWMActive = TRUE;
     PWM_SetFrequency(PWM_DEFAULT_FREQUENCY);
     PWMActivePins = 0;
+    RampActive = 0;
+    PeriodHook = NULL;
+    IEC0CLR = _IEC0_T2IE_MASK;
+    IFS0CLR = _IFS0_T2IF_MASK;
+    IPC2bits.T2IP = RAMP_INT_PRIORITY;
     return SUCCESS;
 }
 
@@ -102,6 +161,8 @@ char PWM_SetFrequency(unsigned int NewFrequency)
     TMR2 = 0;
     T2CONbits.ON = 1;
     PWMFrequency = NewFrequency;
+    /* rounded up so MAX_PWM gives exactly PR2 + 1 */
+    DutyScale = (unsigned int) ((((unsigned long long) (PR2 + 1) << DUTY_SHIFT) + MAX_PWM - 1) / MAX_PWM);
     return SUCCESS;
 }
 
@@ -177,6 +238,7 @@ char PWM_RemovePins(unsigned int PWMPins)
         dbprintf("%s Returning ERROR for pins already in state: %X \r\n", __FUNCTION__, PWMPins);
         return ERROR;
     }
+    CancelRamp(PWMPins);
     int PinCount = 0;
     for (PinCount = 0; PinCount < ALLPWMPINS; PinCount++) {
         if (PWMPins & (1 << PinCount)) {
@@ -228,15 +290,10 @@ char PWM_SetDutyCycle(unsigned char Channel, unsigned int Duty)
         return ERROR;
     }
 
-    unsigned int ScaledDuty = 0;
-    unsigned int TranslatedChannel = 0;
-    ScaledDuty = ((PR2 + 1) * Duty) / MAX_PWM;
-    while (Channel > 1) {
-        Channel >>= 1;
-        TranslatedChannel++;
-    }
-    dbprintf("Translated Channel is %d and Scaled Duty is %d\r\n", TranslatedChannel, ScaledDuty);
-    *Duty_Registers[TranslatedChannel] = ScaledDuty;
+    CancelRamp(Channel);
+    unsigned int TranslatedChannel = ChannelIndex(Channel);
+    dbprintf("Translated Channel is %d and Duty is %d\r\n", TranslatedChannel, Duty);
+    WriteDuty(TranslatedChannel, Duty);
     return SUCCESS;
 
 }
@@ -284,6 +341,118 @@ unsigned int PWM_GetDutyCycle(char Channel)
 
 }
 
+/**
+ * Function  PWM_GetHandle
+ * @param Channel, use #defined PWM_PORTxxx (one channel, already added)
+ * @return Handle for PWM_SetDutyFast(), or PWM_NO_HANDLE */
+PWM_Handle PWM_GetHandle(unsigned char Channel)
+{
+    if (!PWMActive || (Channel == 0) || (Channel & (Channel - 1)) || !(Channel & PWMActivePins)) {
+        dbprintf("%s returning no handle for pin: %X\r\n", __FUNCTION__, Channel);
+        return PWM_NO_HANDLE;
+    }
+    return ChannelIndex(Channel);
+}
+
+/**
+ * Function  PWM_SetDutyFast
+ * @param Handle, from PWM_GetHandle()
+ * @param Duty, duty cycle for the channel (0-1000), not checked */
+void PWM_SetDutyFast(PWM_Handle Handle, unsigned int Duty)
+{
+    if (RampActive & (1 << Handle)) {
+        CancelRamp(1 << Handle);
+    }
+    WriteDuty(Handle, Duty);
+}
+
+/**
+ * Function  PWM_SetDutyBatch
+ * @param Handles, Duties, Count: Count channels and the duty for each */
+void PWM_SetDutyBatch(const PWM_Handle *Handles, const unsigned short *Duties,
+        unsigned char Count)
+{
+    unsigned char i;
+    for (i = 0; i < Count; i++) {
+        PWM_SetDutyFast(Handles[i], Duties[i]);
+    }
+}
+
+/**
+ * Function  PWM_Ramp
+ * @param Channel, use #defined PWM_PORTxxx (one channel)
+ * @param Duty, duty cycle to end at (0-1000)
+ * @param RampMs, time to get there in ms; 0 sets the duty at once
+ * @param Profile, shape of the ramp
+ * @return SUCCESS or ERROR
+ * @remark Starts the ramp from the channel's current duty; the Timer2
+ *         interrupt steps it once per PWM period. */
+char PWM_Ramp(unsigned char Channel, unsigned int Duty, unsigned int RampMs,
+        const RampProfile_t *Profile)
+{
+    if (!PWMActive) {
+        dbprintf("%s returning ERROR before enable\r\n", __FUNCTION__);
+        return ERROR;
+    }
+    if ((Channel == 0) || (Channel > ALLPWMPINS) || (Channel & (Channel - 1))) {
+        dbprintf("%s returning error with pin out of bounds: %X\r\n", __FUNCTION__, Channel);
+        return ERROR;
+    }
+    if (!(Channel & PWMActivePins)) {
+        dbprintf("%s returning error with unactivated pin: %X %X\r\n", __FUNCTION__, Channel, PWMActivePins);
+        return ERROR;
+    }
+    if ((Duty > MAX_PWM) || (Profile == NULL) || (Profile->Count < 2)) {
+        dbprintf("%s returning error with duty or profile out of bounds: %d\r\n", __FUNCTION__, Duty);
+        return ERROR;
+    }
+    unsigned int Ticks = (RampMs * PWMFrequency) / 1000;
+    unsigned int i = ChannelIndex(Channel);
+    CancelRamp(Channel);
+    if (Ticks == 0) {
+        WriteDuty(i, Duty);
+        return SUCCESS;
+    }
+    IEC0CLR = _IEC0_T2IE_MASK;
+    RampProfile[i] = Profile;
+    RampFrom[i] = DutyNow[i];
+    RampTo[i] = Duty;
+    RampTick[i] = 0;
+    RampTicks[i] = Ticks;
+    RampActive |= Channel;
+    IEC0SET = _IEC0_T2IE_MASK;
+    return SUCCESS;
+}
+
+/**
+ * Function  PWM_IsRampDone
+ * @param Channel, use #defined PWM_PORTxxx
+ * @return TRUE if no ramp is running on the channel, else FALSE */
+char PWM_IsRampDone(unsigned char Channel)
+{
+    return (RampActive & Channel) ? FALSE : TRUE;
+}
+
+/**
+ * Function  PWM_SetPeriodHook
+ * @param Hook, function to call once per PWM period, or NULL to stop
+ * @return SUCCESS or ERROR
+ * @remark Runs Hook from the Timer2 interrupt (RAMP_INT_PRIORITY) after the
+ *         ramps have stepped, so it can time a control loop off the PWM. */
+char PWM_SetPeriodHook(void (*Hook)(void))
+{
+    if (!PWMActive) {
+        dbprintf("%s returning ERROR before enable\r\n", __FUNCTION__);
+        return ERROR;
+    }
+    IEC0CLR = _IEC0_T2IE_MASK;
+    PeriodHook = Hook;
+    if (RampActive || PeriodHook) {
+        IEC0SET = _IEC0_T2IE_MASK;
+    }
+    return SUCCESS;
+}
+
 /**
  * Function: PWM_End
  * @param None
@@ -297,11 +466,14 @@ char PWM_End(void)
     if (!PWMActive) {
         return ERROR;
     }
+    IEC0CLR = _IEC0_T2IE_MASK | _IEC0_OC1IE_MASK | _IEC0_OC2IE_MASK | _IEC0_OC3IE_MASK | _IEC0_OC4IE_MASK | _IEC0_OC5IE_MASK;
+    RampActive = 0;
+    PeriodHook = NULL;
     for (Curpin = 0; Curpin < NUM_PWM_CHANNELS; Curpin++) {
         *Duty_Registers[Curpin] = 0;
         *Reset_Registers[Curpin] = 0;
+        DutyNow[Curpin] = 0;
     }
-    IEC0CLR = _IEC0_T2IE_MASK | _IEC0_OC1IE_MASK | _IEC0_OC2IE_MASK | _IEC0_OC3IE_MASK | _IEC0_OC4IE_MASK | _IEC0_OC5IE_MASK;
 
     PWMActive = FALSE;
     PWMFrequency = 0;
@@ -309,6 +481,36 @@ char PWM_End(void)
 }
 
 
+/*******************************************************************************
+ * INTERRUPT SERVICE ROUTINE                                                   *
+ ******************************************************************************/
+
+/**
+ * Timer2IntHandler
+ *   Once per PWM period while any ramp runs or a period hook is set: moves
+ *   each ramping channel one step along its profile, ends finished ramps,
+ *   calls the hook, and turns itself off when there is nothing left to do.
+ */
+void __ISR(_TIMER_2_VECTOR, IPL3SOFT) Timer2IntHandler(void)
+{
+    unsigned int i;
+    IFS0CLR = _IFS0_T2IF_MASK;
+    for (i = 0; i < NUM_PWM_CHANNELS; i++) {
+        if (RampActive & (1 << i)) {
+            RampTick[i]++;
+            WriteDuty(i, Ramp_At(RampProfile[i], RampFrom[i], RampTo[i], RampTick[i], RampTicks[i]));
+            if (RampTick[i] >= RampTicks[i]) {
+                RampActive &= ~(1 << i);
+            }
+        }
+    }
+    if (PeriodHook) {
+        PeriodHook();
+    } else if (!RampActive) {
+        IEC0CLR = _IEC0_T2IE_MASK;
+    }
+}
+
 /*******************************************************************************
  * TEST HARNESS                                                                *
  ******************************************************************************/
@@ -329,6 +531,7 @@ char PWM_End(void)
 #define PWM_PORT     PWM_PORTX04
 
 #define FIFTY_PERCENT_DUTY 500
+#define BENCH_REPS  1000
 //#define GetArray(Name)  Name ## Goober
 //#define GetArrayWrapper()
 //#define Str(x)   #Str
@@ -762,6 +965,57 @@ int main(void)
     if (testPassed) printf("PASSED");
     printf("\nPWM_GetPulseTime() Tests complete");
 
+    /***************************************************************************
+     *            BENCHMARK PWM_SETDUTYCYCLE() AGAINST THE FAST PATH            *
+     ***************************************************************************/
+    printf("\n\nBenchmark: core timer ticks (SYSCLK/2) per duty update, %d updates", BENCH_REPS);
+    {
+        PWM_Handle handles[NUM_PWM_CHANNELS];
+        unsigned short duties[NUM_PWM_CHANNELS];
+        unsigned int n, t;
+        for (i = 0; i < NUM_PWM_CHANNELS; i++) {
+            handles[i] = PWM_GetHandle(1 << i);
+            duties[i] = FIFTY_PERCENT_DUTY;
+        }
+        testPassed = TRUE;
+        for (duty = MIN_PWM; duty <= MAX_PWM; duty++) {
+            PWM_SetDutyFast(handles[0], duty);
+            if (OC1RS != ((PR2 + 1) * duty) / MAX_PWM) {
+                testPassed = FALSE;
+            }
+        }
+        printf("\nFast path matches ((PR2 + 1) * Duty) / MAX_PWM for every duty: %s",
+                testPassed ? "PASSED" : "FAILED");
+
+        _CP0_SET_COUNT(0);
+        for (n = 0; n < BENCH_REPS; n++) {
+            PWM_SetDutyCycle(PWM_PORTZ06, n & 0x1FF);
+        }
+        t = _CP0_GET_COUNT();
+        printf("\nPWM_SetDutyCycle:          %u.%02u", t / BENCH_REPS, (t % BENCH_REPS) * 100 / BENCH_REPS);
+        _CP0_SET_COUNT(0);
+        for (n = 0; n < BENCH_REPS; n++) {
+            PWM_SetDutyFast(handles[0], n & 0x1FF);
+        }
+        t = _CP0_GET_COUNT();
+        printf("\nPWM_SetDutyFast:           %u.%02u", t / BENCH_REPS, (t % BENCH_REPS) * 100 / BENCH_REPS);
+        _CP0_SET_COUNT(0);
+        for (n = 0; n < BENCH_REPS; n++) {
+            for (i = 1; i <= ALLPWMPINS; i <<= 1) {
+                PWM_SetDutyCycle(i, n & 0x1FF);
+            }
+        }
+        t = _CP0_GET_COUNT();
+        printf("\n5 x PWM_SetDutyCycle:      %u.%02u", t / BENCH_REPS, (t % BENCH_REPS) * 100 / BENCH_REPS);
+        _CP0_SET_COUNT(0);
+        for (n = 0; n < BENCH_REPS; n++) {
+            duties[0] = n & 0x1FF;
+            PWM_SetDutyBatch(handles, duties, NUM_PWM_CHANNELS);
+        }
+        t = _CP0_GET_COUNT();
+        printf("\nPWM_SetDutyBatch (5):      %u.%02u", t / BENCH_REPS, (t % BENCH_REPS) * 100 / BENCH_REPS);
+    }
+
 
 
     /***************************************************************************
@@ -6,7 +6,9 @@
  * which the PWM works are #defined below (PortZ-6, PortY-4,10,12, and PortX-11),
  * and are set by the hardware (cannot be modified).
  *
- * NOTE: Module uses TIMER2 for its interrupts.
+ * NOTE: Module uses TIMER2 for its interrupts. The Timer2 interrupt is only
+ * enabled while a duty ramp (PWM_Ramp) is running or a period hook
+ * (PWM_SetPeriodHook) is set; it runs once per PWM period.
  *
  * PWM_TEST (in the .c file) conditionally compiles the test harness for the code. 
  * 
@@ -17,6 +19,8 @@
 #ifndef pwm_H
 #define pwm_H
 
+#include "RampShape.h"
+
 /*******************************************************************************
  * PUBLIC #DEFINES                                                             *
  ******************************************************************************/
@@ -41,6 +45,10 @@
 #define MIN_PWM 0
 #define MAX_PWM 1000
 
+/* Handle for the fast duty path: the channel's index, resolved once */
+typedef unsigned char PWM_Handle;
+#define PWM_NO_HANDLE 0xFF
+
 
 
 /*******************************************************************************
@@ -118,6 +126,60 @@ char PWM_SetDutyCycle(unsigned char Channel, unsigned int Duty);
  * @date 2011.11.12  */
 unsigned int PWM_GetDutyCycle(char Channel);
 
+/**
+ * Function  PWM_GetHandle
+ * @param Channel, use #defined PWM_PORTxxx (one channel, already added)
+ * @return Handle for PWM_SetDutyFast(), or PWM_NO_HANDLE if the channel is
+ *         not a single active pin
+ * @remark The handle stays valid until the pin is removed or PWM_End(). */
+PWM_Handle PWM_GetHandle(unsigned char Channel);
+
+/**
+ * Function  PWM_SetDutyFast
+ * @param Handle, from PWM_GetHandle()
+ * @param Duty, duty cycle for the channel (0-1000), not checked
+ * @remark Fast path for frequent updates: no validation, one multiply-shift
+ *         by the scale worked out at PWM_SetFrequency() and one register
+ *         write. Cancels a ramp running on the channel, like PWM_SetDutyCycle. */
+void PWM_SetDutyFast(PWM_Handle Handle, unsigned int Duty);
+
+/**
+ * Function  PWM_SetDutyBatch
+ * @param Handles, Duties, Count: Count channels and the duty for each
+ * @remark PWM_SetDutyFast() for several channels back to back, so they
+ *         change within a few instructions of each other. */
+void PWM_SetDutyBatch(const PWM_Handle *Handles, const unsigned short *Duties,
+        unsigned char Count);
+
+/**
+ * Function  PWM_Ramp
+ * @param Channel, use #defined PWM_PORTxxx (one channel)
+ * @param Duty, duty cycle to end at (0-1000)
+ * @param RampMs, time to get there in ms; 0 sets the duty at once
+ * @param Profile, shape of the ramp (Ramp_Linear, Ramp_Exp or a custom table)
+ * @return SUCCESS or ERROR
+ * @remark Moves the channel from its current duty to Duty along Profile, one
+ *         step per PWM period from the Timer2 interrupt. PWM_SetDutyCycle() on
+ *         the channel cancels the ramp. The ramp length is worked out at the
+ *         frequency in force when it starts. */
+char PWM_Ramp(unsigned char Channel, unsigned int Duty, unsigned int RampMs,
+        const RampProfile_t *Profile);
+
+/**
+ * Function  PWM_IsRampDone
+ * @param Channel, use #defined PWM_PORTxxx
+ * @return TRUE if no ramp is running on the channel, else FALSE */
+char PWM_IsRampDone(unsigned char Channel);
+
+/**
+ * Function  PWM_SetPeriodHook
+ * @param Hook, function to call once per PWM period, or NULL to stop
+ * @return SUCCESS or ERROR
+ * @remark Hook runs in the Timer2 interrupt at IPL3, after the ramps have
+ *         stepped, so it must be short. It may use PWM_SetDutyFast() on a
+ *         channel with no ramp running. */
+char PWM_SetPeriodHook(void (*Hook)(void));
+
 /**
  * Function: PWM_End
  * @param None